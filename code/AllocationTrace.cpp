@@ -0,0 +1,138 @@
+#include "AllocationTrace.h"
+#include "Os.h"
+#include "MiscUtil.h"
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <intrin.h>
+
+namespace gg {
+
+#if GG_TRACE_HEAP_ALLOCATIONS
+
+static thread_local unsigned t_regionDepth = 0;
+static thread_local uint64_t t_region = 0;
+static thread_local bool t_recording = false;
+
+static std::atomic<uint64_t> s_regionsEntered = {0};
+static std::atomic<uint64_t> s_regionsCompleted = {0};
+static std::atomic<uint64_t> s_allocationCount = {0};
+static std::atomic<uint64_t> s_allocatedBytes = {0};
+static std::atomic<uint64_t> s_droppedRecords = {0};
+static unsigned s_warmupRegions = 0;
+static bool s_breakOnAllocation = false;
+
+static std::mutex s_recordMutex;
+static HeapTrace::Record s_records[HeapTrace::cMaxRecords];
+static unsigned s_recordCount = 0;
+
+void HeapTrace::Configure(unsigned warmupRegions, bool breakOnAllocation) {
+    s_warmupRegions = warmupRegions;
+    s_breakOnAllocation = breakOnAllocation;
+}
+
+void HeapTrace::EnterRegion() {
+    if (t_regionDepth++ == 0) {
+        t_region = s_regionsEntered.fetch_add(1, std::memory_order_relaxed);
+        t_recording = t_region >= s_warmupRegions;
+    }
+}
+
+void HeapTrace::LeaveRegion() {
+    assert(t_regionDepth > 0);
+    if (--t_regionDepth == 0 && std::exchange(t_recording, false)) {
+        s_regionsCompleted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void HeapTrace::RecordAllocation(size_t bytes) {
+    if (!t_recording) {
+        return;
+    }
+    s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    s_allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(s_recordMutex);
+        if (s_recordCount < cMaxRecords) {
+            Record& record = s_records[s_recordCount++];
+            record.bytes = bytes;
+            record.region = t_region;
+            record.stackDepth = Os::CaptureCallStack(record.stack, cMaxStackDepth, 1);
+        } else {
+            s_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (s_breakOnAllocation) {
+        Os::PrintDebug("Heap allocation inside a hot region (see HeapTrace::Report())\n");
+        if (Os::IsDebuggerPresent()) {
+            __debugbreak();
+        }
+    }
+}
+
+HeapTrace::Summary HeapTrace::GetSummary() {
+    return {
+        s_regionsCompleted.load(std::memory_order_relaxed),
+        s_allocationCount.load(std::memory_order_relaxed),
+        s_allocatedBytes.load(std::memory_order_relaxed),
+        s_droppedRecords.load(std::memory_order_relaxed),
+    };
+}
+
+void HeapTrace::Report(void (*printLine)(char const* text)) {
+    char line[256];
+    Summary const summary = GetSummary();
+    snprintf(line, sizeof(line), "Hot regions: %llu, heap allocations: %llu (%.2f per region), %llu bytes\n",
+        (unsigned long long)summary.regionCount,
+        (unsigned long long)summary.allocationCount,
+        summary.allocationsPerRegion(),
+        (unsigned long long)summary.allocatedBytes);
+    printLine(line);
+    std::lock_guard<std::mutex> lock(s_recordMutex);
+    for (unsigned i = 0; i < s_recordCount; i++) {
+        Record const& record = s_records[i];
+        snprintf(line, sizeof(line), "  %llu bytes in region %llu, from:\n", (unsigned long long)record.bytes, (unsigned long long)record.region);
+        printLine(line);
+        for (unsigned depth = 0; depth < record.stackDepth; depth++) {
+            snprintf(line, sizeof(line), "    %p\n", record.stack[depth]);
+            printLine(line);
+        }
+    }
+    if (summary.droppedRecords) {
+        snprintf(line, sizeof(line), "  (%llu more not recorded)\n", (unsigned long long)summary.droppedRecords);
+        printLine(line);
+    }
+}
+
+void HeapTrace::Reset() {
+    std::lock_guard<std::mutex> lock(s_recordMutex);
+    s_recordCount = 0;
+    s_regionsEntered = 0;
+    s_regionsCompleted = 0;
+    s_allocationCount = 0;
+    s_allocatedBytes = 0;
+    s_droppedRecords = 0;
+}
+
+#else
+
+void HeapTrace::Configure(unsigned, bool) {
+}
+
+HeapTrace::Summary HeapTrace::GetSummary() {
+    return {};
+}
+
+void HeapTrace::Report(void (*printLine)(char const* text)) {
+    printLine("Heap allocation tracing is disabled (GG_TRACE_HEAP_ALLOCATIONS)\n");
+}
+
+void HeapTrace::Reset() {
+}
+
+void HeapTrace::RecordAllocation(size_t) {
+}
+
+#endif
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef GG_ALLOCATION_TRACE_H
+#define GG_ALLOCATION_TRACE_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Opt-in tracing of heap allocations made inside a HotRegion (e.g. the frame loop). Off, it compiles away.
+// Mallocator, SlabHeap (so SlabAllocator) and ThreadCachingAllocator each record the requests they serve, also
+// those served from a free list; arenas only record the chunks they get from Mallocator.
+#ifndef GG_TRACE_HEAP_ALLOCATIONS
+#define GG_TRACE_HEAP_ALLOCATIONS 0
+#endif
+
+#if GG_TRACE_HEAP_ALLOCATIONS
+#define GG_TRACE_HEAP_ALLOCATION(bytes) gg::HeapTrace::RecordAllocation(bytes)
+#else
+#define GG_TRACE_HEAP_ALLOCATION(bytes) ((void)0)
+#endif
+
+namespace gg {
+
+class HeapTrace {
+public:
+    enum {
+        cMaxRecords = 256,
+        cMaxStackDepth = 16,
+    };
+
+    struct Record {
+        size_t bytes;
+        uint64_t region;
+        unsigned stackDepth;
+        void* stack[cMaxStackDepth];
+    };
+
+    struct Summary {
+        uint64_t regionCount;       // (completed, after warm-up)
+        uint64_t allocationCount;
+        uint64_t allocatedBytes;
+        uint64_t droppedRecords;
+
+        float allocationsPerRegion() const {
+            return regionCount ? (float)allocationCount / regionCount : 0.f;
+        }
+    };
+
+    // The first warmupRegions hot regions are ignored, so first-use growth isn't reported. With
+    // breakOnAllocation, each recorded allocation is also printed to the debug output at once, and breaks into
+    // the debugger if one is attached (in any build).
+    static void Configure(unsigned warmupRegions, bool breakOnAllocation);
+
+    static Summary GetSummary();
+    static void Report(void (*printLine)(char const* text));
+    static void Reset();    // (also restarts the warm-up)
+
+    static void RecordAllocation(size_t bytes);
+
+private:
+    friend class HotRegion;
+    static void EnterRegion();
+    static void LeaveRegion();
+};
+
+// Marks a stretch of code that should not touch the heap in steady state. Regions may nest.
+class HotRegion {
+public:
+    HotRegion() {
+#if GG_TRACE_HEAP_ALLOCATIONS
+        HeapTrace::EnterRegion();
+#endif
+    }
+    HotRegion(HotRegion const&) = delete;
+    ~HotRegion() {
+#if GG_TRACE_HEAP_ALLOCATIONS
+        HeapTrace::LeaveRegion();
+#endif
+    }
+};
+
+}
+
+#endif
@@ -1,7 +1,267 @@
 #include "Allocator.h"
+#include <mutex>
 
 namespace gg {
 
 IAllocatorShim<Mallocator> Mallocator::s_iallocatorImpl;
 
+SlabAllocator::ImmortalHeap SlabAllocator::s_heap;
+SpinLock SlabAllocator::s_lock;
+IAllocatorShim<SlabAllocator> SlabAllocator::s_iallocatorImpl;
+
+// Backing memory for the pooled allocators, which have already traced the request it serves
+static void* AllocateUntraced(size_t bytes, size_t alignment) {
+    return _aligned_malloc(bytes, alignment);
+}
+
+SlabHeap::~SlabHeap() {
+    for (SizeClass& sc : classes_) {
+        while (sc.pages) {
+            Mallocator().deallocate(std::exchange(sc.pages, sc.pages->next));
+        }
+    }
+}
+
+SlabHeap::ClassStats SlabHeap::getClassStats(unsigned sizeClass) const {
+    assert(sizeClass < cSizeClassCount);
+    SizeClass const& sc = classes_[sizeClass];
+    size_t const blockSize = (size_t)1 << (sizeClass + cMinBlockShift);
+    unsigned const blocksPerPage = (unsigned)((cPageSize - GetFirstBlockOffset(blockSize)) / blockSize);
+    return {blockSize, sc.pageCount, sc.blocksInUse, sc.pageCount * blocksPerPage};
+}
+
+void SlabHeap::addPage(unsigned sizeClass) {
+    SizeClass& sc = classes_[sizeClass];
+    size_t const blockSize = (size_t)1 << (sizeClass + cMinBlockShift);
+    Page* const page = (Page*)AllocateUntraced(cPageSize, cPageSize);
+    page->next = std::exchange(sc.pages, page);
+    page->sizeClass = sizeClass;
+    page->bytes = cPageSize;
+    sc.pageCount++;
+
+    // Thread the page's blocks onto the free list, lowest address first
+    char* const first = (char*)page + GetFirstBlockOffset(blockSize);
+    for (char* block = (char*)page + cPageSize - blockSize; block >= first; block -= blockSize) {
+        sc.freeList = new(block) FreeBlock{sc.freeList};
+    }
+}
+
+void* SlabHeap::allocateLarge(size_t bytes, size_t alignment) {
+    assert(alignment < cPageSize);
+    size_t const offset = (sizeof(Page) + alignment - 1) & ~(alignment - 1);
+    Page* const page = (Page*)AllocateUntraced(offset + bytes, cPageSize);
+    page->next = nullptr;
+    page->sizeClass = cSizeClassCount;
+    page->bytes = bytes;
+    largeBlocksInUse_++;
+    largeBytesInUse_ += bytes;
+    return (char*)page + offset;
+}
+
+void SlabHeap::deallocateLarge(Page* page) {
+    assert(largeBlocksInUse_ > 0);
+    largeBlocksInUse_--;
+    largeBytesInUse_ -= page->bytes;
+    Mallocator().deallocate(page);
+}
+
+struct ThreadCachingAllocator::Header {
+    void* base;
+    size_t sizeClass;
+};
+
+struct ThreadCachingAllocator::FreeBlock {
+    FreeBlock* next;
+    FreeBlock* nextBatch;
+};
+
+struct ThreadCachingAllocator::Magazine {
+    unsigned count = 0;
+    void* blocks[2 * cBatchSize];
+};
+
+// Set once the calling thread's cache has been destroyed (thread_local destruction order is unspecified, so
+// other thread_locals may still free or allocate after it)
+static thread_local bool t_threadCacheGone = false;
+
+struct ThreadCachingAllocator::ThreadCache {
+    ~ThreadCache() {
+        flush();
+        t_threadCacheGone = true;
+    }
+    void flush() {
+        for (unsigned sizeClass = 0; sizeClass < cSizeClassCount; sizeClass++) {
+            while (magazines[sizeClass].count) {
+                Spill(sizeClass, magazines[sizeClass], std::min(magazines[sizeClass].count, (unsigned)cBatchSize));
+            }
+        }
+    }
+    Magazine magazines[cSizeClassCount];
+};
+
+// (A SpinLock, unlike std::mutex on MSVC 2015, keeps the depots constant-initialized)
+struct ThreadCachingAllocator::Depot {
+    SpinLock lock;
+    FreeBlock* batches = nullptr;
+};
+
+// Constant-initialized, and its destructor leaves the depots alone
+union ThreadCachingAllocator::ImmortalDepots {
+    constexpr ImmortalDepots()
+        : depots() {
+    }
+    ~ImmortalDepots() {
+    }
+    Depot depots[cSizeClassCount];
+};
+
+ThreadCachingAllocator::ImmortalDepots ThreadCachingAllocator::s_depots;
+IAllocatorShim<ThreadCachingAllocator> ThreadCachingAllocator::s_iallocatorImpl;
+
+ThreadCachingAllocator::ThreadCache& ThreadCachingAllocator::GetThreadCache() {
+    static thread_local ThreadCache threadCache;
+    return threadCache;
+}
+
+void* ThreadCachingAllocator::allocate(size_t bytes, size_t alignment) const {
+    static_assert(sizeof(Header) <= cMaxCachedAlignment, "Header must not disturb block alignment");
+    GG_TRACE_HEAP_ALLOCATION(bytes);
+    if (alignment <= cMaxCachedAlignment && bytes <= ((size_t)1 << cMaxBlockShift)) {
+        unsigned const sizeClass = CeilingLog2((uint64_t)std::max(bytes, (size_t)1 << cMinBlockShift)) - cMinBlockShift;
+        if (!t_threadCacheGone) {
+            Magazine& magazine = GetThreadCache().magazines[sizeClass];
+            if (magazine.count == 0) {
+                Refill(sizeClass, magazine);
+            }
+            if (magazine.count) {
+                return magazine.blocks[--magazine.count];
+            }
+        }
+        Header* const header = (Header*)AllocateUntraced(cMaxCachedAlignment + ((size_t)1 << (sizeClass + cMinBlockShift)), cMaxCachedAlignment);
+        header->base = header;
+        header->sizeClass = sizeClass;
+        return (char*)header + cMaxCachedAlignment;
+    }
+    // Uncached; still needs a header so deallocate() can tell
+    size_t const offset = std::max(alignment, (size_t)cMaxCachedAlignment);
+    char* const base = (char*)AllocateUntraced(offset + bytes, offset);
+    Header* const header = (Header*)(base + offset) - 1;
+    header->base = base;
+    header->sizeClass = cSizeClassCount;
+    return base + offset;
+}
+
+void ThreadCachingAllocator::deallocate(void const* p) const {
+    if (!p) {
+        return;
+    }
+    Header const* const header = (Header const*)p - 1;
+    if (header->sizeClass >= cSizeClassCount) {
+        Mallocator().deallocate(header->base);
+        return;
+    }
+    unsigned const sizeClass = (unsigned)header->sizeClass;
+    if (t_threadCacheGone) {
+        Depot& depot = s_depots.depots[sizeClass];
+        std::lock_guard<SpinLock> lock(depot.lock);
+        depot.batches = new((void*)p) FreeBlock{nullptr, depot.batches};   // (a batch of one)
+        return;
+    }
+    Magazine& magazine = GetThreadCache().magazines[sizeClass];
+    if (magazine.count == CountOf(magazine.blocks)) {
+        Spill(sizeClass, magazine, cBatchSize);
+    }
+    magazine.blocks[magazine.count++] = (void*)p;
+}
+
+void ThreadCachingAllocator::FlushThreadCache() {
+    GetThreadCache().flush();
+}
+
+void ThreadCachingAllocator::Spill(unsigned sizeClass, Magazine& magazine, unsigned count) {
+    assert(count > 0 && count <= magazine.count);
+    FreeBlock* batch = nullptr;
+    for (unsigned i = 0; i < count; i++) {
+        batch = new(magazine.blocks[--magazine.count]) FreeBlock{batch, nullptr};
+    }
+    Depot& depot = s_depots.depots[sizeClass];
+    std::lock_guard<SpinLock> lock(depot.lock);
+    batch->nextBatch = std::exchange(depot.batches, batch);
+}
+
+void ThreadCachingAllocator::Refill(unsigned sizeClass, Magazine& magazine) {
+    Depot& depot = s_depots.depots[sizeClass];
+    FreeBlock* batch;
+    {
+        std::lock_guard<SpinLock> lock(depot.lock);
+        batch = depot.batches;
+        if (batch) {
+            depot.batches = batch->nextBatch;
+        }
+    }
+    for (; batch; batch = batch->next) {
+        magazine.blocks[magazine.count++] = batch;
+    }
+}
+
+ScratchStack& ScratchStack::Get() {
+    static thread_local ScratchStack threadStack;
+    return threadStack;
+}
+
+ScratchStack::~ScratchStack() {
+    while (firstPage_) {
+        Mallocator().deallocate(std::exchange(firstPage_, firstPage_->next));
+    }
+}
+
+void* ScratchStack::allocateFromNextPage(size_t bytes, size_t alignment) {
+    Page*& next = page_ ? page_->next : firstPage_;
+    size_t const needed = sizeof(Page) + alignment + bytes;
+    if (!next || next->size < needed) {
+        // Insert a new page; any smaller one after it stays put for shallower use later
+        size_t const size = std::max((size_t)cPageSize, needed);
+        Page* const page = (Page*)Mallocator().allocate(size, alignof(Page));
+        page->next = next;
+        page->size = size;
+        next = page;
+    }
+    page_ = next;
+    cursor_ = (char*)(page_ + 1);
+    limit_ = (char*)page_ + page_->size;
+    return allocate(bytes, alignment);
+}
+
+void* LinearArena::allocateFromNewChunk(size_t bytes, size_t alignment) {
+    size_t const size = std::max(chunkSize_, sizeof(Chunk) + alignment + bytes);
+    Chunk* const chunk = (Chunk*)Mallocator().allocate(size, alignof(Chunk));
+    chunk->next = chunks_;
+    chunk->size = size;
+    chunks_ = chunk;
+    cursor_ = (char*)(chunk + 1);
+    limit_ = (char*)chunk + size;
+    return allocate(bytes, alignment);
+}
+
+size_t LinearArena::releaseChunks() {
+    size_t total = 0;
+    while (chunks_) {
+        total += chunks_->size;
+        Mallocator().deallocate(std::exchange(chunks_, chunks_->next));
+    }
+    cursor_ = limit_ = nullptr;
+    return total;
+}
+
+void LinearArena::reset() {
+    last_ = nullptr;
+    if (chunks_ && chunks_->next) {
+        chunkSize_ = std::max(chunkSize_, releaseChunks());
+        return;
+    }
+    if (chunks_) {
+        cursor_ = (char*)(chunks_ + 1);
+    }
+}
+
 }
@@ -2,7 +2,11 @@
 #ifndef GG_ALLOCATOR_H
 #define GG_ALLOCATOR_H
 
+#include "MiscUtil.h"
+#include "AllocationTrace.h"
+#include "SpinLock.h"
 #include <memory>
+#include <mutex>
 
 namespace gg {
 
@@ -32,6 +36,11 @@ private:
 template<class T_Allocator>
 class IAllocatorShim : public IAllocator {
 public:
+    IAllocatorShim() = default;
+    template<class T_Param>
+    explicit IAllocatorShim(T_Param&& param)
+        : allocator_(std::forward<T_Param>(param)) {
+    }
     virtual void* allocate(size_t bytes, size_t alignment) override final {
         return allocator_.allocate(bytes, alignment);
     }
@@ -45,11 +54,16 @@ private:
 class Mallocator {
 public:
     void* allocate(size_t bytes, size_t alignment) const {
+        GG_TRACE_HEAP_ALLOCATION(bytes);
         return _aligned_malloc(bytes, alignment);
     }
     void deallocate(void const* p) const {
         _aligned_free((void*)p);
     }
+    void* reallocate(void* p, size_t usedBytes, size_t bytes, size_t alignment) const {
+        GG_TRACE_HEAP_ALLOCATION(bytes);
+        return _aligned_realloc(p, bytes, alignment);
+    }
     static IAllocator* getInterface() {
         return &s_iallocatorImpl;
     }
@@ -57,6 +71,413 @@ private:
     static IAllocatorShim<Mallocator> s_iallocatorImpl;
 };
 
+// Bump-pointer allocator for short-lived (e.g. per-frame) data. Individual deallocation is a no-op,
+// except for the most recent allocation, which can be popped or grown in place. reset() releases everything.
+class LinearArena {
+public:
+    enum { cDefaultChunkSize = 64 * 1024 };
+
+    explicit LinearArena(size_t chunkSize = cDefaultChunkSize)
+        : chunkSize_(chunkSize) {
+    }
+    LinearArena(LinearArena&& src)
+        : chunks_(std::exchange(src.chunks_, nullptr))
+        , cursor_(std::exchange(src.cursor_, nullptr))
+        , limit_(std::exchange(src.limit_, nullptr))
+        , last_(std::exchange(src.last_, nullptr))
+        , chunkSize_(src.chunkSize_) {
+    }
+    LinearArena(LinearArena const&) = delete;
+    ~LinearArena() {
+        releaseChunks();
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        uintptr_t const p = ((uintptr_t)cursor_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (p + bytes > (uintptr_t)limit_ || !limit_) {
+            return allocateFromNewChunk(bytes, alignment);
+        }
+        cursor_ = (char*)(p + bytes);
+        return last_ = (void*)p;
+    }
+
+    void deallocate(void const* p) {
+        if (p && p == last_) {
+            cursor_ = (char*)std::exchange(last_, nullptr);
+        }
+    }
+
+    bool tryExtend(void const* p, size_t bytes) {
+        if (!p || p != last_ || bytes > (size_t)(limit_ - (char*)p)) {
+            return false;
+        }
+        cursor_ = (char*)p + bytes;
+        return true;
+    }
+
+    // Invalidates everything allocated from the arena. If the arena had to spill into more than one chunk,
+    // the chunks are coalesced so the same workload fits in a single chunk next time.
+    void reset();
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    GG_NO_INLINE void* allocateFromNewChunk(size_t bytes, size_t alignment);
+    size_t releaseChunks();
+
+    Chunk* chunks_ = nullptr;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+    void const* last_ = nullptr;
+    size_t chunkSize_;
+};
+
+// Lets containers share a LinearArena, e.g. Array<SpritePrim, LinearArenaPtr> prims(&frameArena);
+class LinearArenaPtr {
+public:
+    LinearArenaPtr(LinearArena* arena)
+        : arena_(arena) {
+    }
+    void* allocate(size_t bytes, size_t alignment) const {
+        return arena_->allocate(bytes, alignment);
+    }
+    void deallocate(void const* p) const {
+        arena_->deallocate(p);
+    }
+    bool tryExtend(void const* p, size_t bytes) const {
+        return arena_->tryExtend(p, bytes);
+    }
+private:
+    LinearArena* arena_;
+};
+
+// Segregated-fit allocator: power-of-two size classes carved from page-aligned pages, one intrusive free list
+// per class. Blocks too big for any class get their own page-aligned run. Not thread safe.
+class SlabHeap {
+public:
+    enum {
+        cPageShift = 16,
+        cPageSize = 1 << cPageShift,
+        cMinBlockShift = 4,
+        cMaxBlockShift = cPageShift - 3,
+        cSizeClassCount = cMaxBlockShift - cMinBlockShift + 1,
+    };
+
+    struct ClassStats {
+        size_t blockSize;
+        unsigned pageCount;
+        unsigned blocksInUse;
+        unsigned blockCapacity;
+    };
+
+    constexpr SlabHeap() {
+    }
+    SlabHeap(SlabHeap const&) = delete;
+    ~SlabHeap();
+
+    void* allocate(size_t bytes, size_t alignment) {
+        GG_TRACE_HEAP_ALLOCATION(bytes);
+        unsigned const sizeClass = GetSizeClass(std::max(bytes, alignment));
+        if (sizeClass >= cSizeClassCount) {
+            return allocateLarge(bytes, alignment);
+        }
+        SizeClass& sc = classes_[sizeClass];
+        if (!sc.freeList) {
+            addPage(sizeClass);
+        }
+        sc.blocksInUse++;
+        return std::exchange(sc.freeList, sc.freeList->next);
+    }
+
+    void deallocate(void const* p) {
+        if (!p) {
+            return;
+        }
+        Page* const page = GetPage(p);
+        if (page->sizeClass >= cSizeClassCount) {
+            deallocateLarge(page);
+            return;
+        }
+        SizeClass& sc = classes_[page->sizeClass];
+        assert(sc.blocksInUse > 0);
+        sc.blocksInUse--;
+        sc.freeList = new((void*)p) FreeBlock{sc.freeList};
+    }
+
+    void* reallocate(void* p, size_t usedBytes, size_t bytes, size_t alignment) {
+        if (p && GetPage(p)->sizeClass < cSizeClassCount && GetPage(p)->sizeClass == GetSizeClass(std::max(bytes, alignment))) {
+            return p;
+        }
+        void* const result = allocate(bytes, alignment);
+        if (p) {
+            memcpy(result, p, usedBytes);
+            deallocate(p);
+        }
+        return result;
+    }
+
+    ClassStats getClassStats(unsigned sizeClass) const;
+
+    unsigned largeBlocksInUse() const {
+        return largeBlocksInUse_;
+    }
+
+    size_t largeBytesInUse() const {
+        return largeBytesInUse_;
+    }
+
+    static unsigned GetSizeClass(size_t bytes) {
+        return CeilingLog2((uint64_t)std::max(bytes, (size_t)1 << cMinBlockShift)) - cMinBlockShift;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Page {
+        Page* next;
+        unsigned sizeClass;
+        size_t bytes;
+    };
+
+    struct SizeClass {
+        FreeBlock* freeList = nullptr;
+        Page* pages = nullptr;
+        unsigned pageCount = 0;
+        unsigned blocksInUse = 0;
+    };
+
+    static Page* GetPage(void const* p) {
+        return (Page*)((uintptr_t)p & ~(uintptr_t)(cPageSize - 1));
+    }
+
+    static size_t GetFirstBlockOffset(size_t blockSize) {
+        return (sizeof(Page) + blockSize - 1) & ~(blockSize - 1);
+    }
+
+    GG_NO_INLINE void addPage(unsigned sizeClass);
+    GG_NO_INLINE void* allocateLarge(size_t bytes, size_t alignment);
+    GG_NO_INLINE void deallocateLarge(Page* page);
+
+    SizeClass classes_[cSizeClassCount] = {};
+    unsigned largeBlocksInUse_ = 0;
+    size_t largeBytesInUse_ = 0;
+};
+
+// Drop-in T_Allocator backed by a process-wide SlabHeap behind a SpinLock, so blocks may be allocated and freed
+// on any thread (for heavily contended use, see ThreadCachingAllocator). The heap is never destroyed: blocks freed
+// by other statics' destructors during shutdown still find it, and its pages go back with the process.
+class SlabAllocator {
+public:
+    void* allocate(size_t bytes, size_t alignment) const {
+        std::lock_guard<SpinLock> lock(s_lock);
+        return s_heap.heap.allocate(bytes, alignment);
+    }
+    void deallocate(void const* p) const {
+        if (!p) {
+            return;
+        }
+        std::lock_guard<SpinLock> lock(s_lock);
+        s_heap.heap.deallocate(p);
+    }
+    void* reallocate(void* p, size_t usedBytes, size_t bytes, size_t alignment) const {
+        std::lock_guard<SpinLock> lock(s_lock);
+        return s_heap.heap.reallocate(p, usedBytes, bytes, alignment);
+    }
+    // (Unlocked: a snapshot, if other threads are allocating)
+    static SlabHeap const& GetHeap() {
+        return s_heap.heap;
+    }
+    static IAllocator* getInterface() {
+        return &s_iallocatorImpl;
+    }
+private:
+    // Constant-initialized, and its destructor leaves the heap alone
+    union ImmortalHeap {
+        constexpr ImmortalHeap()
+            : heap() {
+        }
+        ~ImmortalHeap() {
+        }
+        SlabHeap heap;
+    };
+
+    static ImmortalHeap s_heap;
+    static SpinLock s_lock;
+    static IAllocatorShim<SlabAllocator> s_iallocatorImpl;
+};
+
+// Mallocator front-end that keeps per-thread magazines of freed blocks for each size class, so most allocations
+// never touch the CRT heap (or its lock). Magazines spill into, and refill from, a shared depot in batches.
+// Blocks may be freed on any thread, also by statics torn down at exit: the depots are never destroyed, and a
+// thread whose cache is already gone goes straight to them.
+class ThreadCachingAllocator {
+public:
+    enum {
+        cMinBlockShift = 4,
+        cMaxBlockShift = 15,
+        cSizeClassCount = cMaxBlockShift - cMinBlockShift + 1,
+        cBatchSize = 32,
+        cMaxCachedAlignment = 16,
+    };
+
+    void* allocate(size_t bytes, size_t alignment) const;
+    void deallocate(void const* p) const;
+
+    // Returns the calling thread's cached blocks to the depot (also happens at thread exit)
+    static void FlushThreadCache();
+
+    static IAllocator* getInterface() {
+        return &s_iallocatorImpl;
+    }
+
+private:
+    struct Header;
+    struct FreeBlock;
+    struct Magazine;
+    struct ThreadCache;
+    struct Depot;
+    union ImmortalDepots;
+
+    static ThreadCache& GetThreadCache();
+    GG_NO_INLINE static void Spill(unsigned sizeClass, Magazine& magazine, unsigned count);
+    GG_NO_INLINE static void Refill(unsigned sizeClass, Magazine& magazine);
+
+    static ImmortalDepots s_depots;
+    static IAllocatorShim<ThreadCachingAllocator> s_iallocatorImpl;
+};
+
+// Per-thread stack of memory for temporaries, used through ScratchScope. It bumps a pointer like alloca, but
+// spills onto further heap pages rather than overflowing; pages are kept for reuse until the thread exits.
+class ScratchStack {
+public:
+    enum { cPageSize = 64 * 1024 };
+
+    static ScratchStack& Get();
+
+    void* allocate(size_t bytes, size_t alignment) {
+        uintptr_t const p = ((uintptr_t)cursor_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (p + bytes > (uintptr_t)limit_ || !limit_) {
+            return allocateFromNextPage(bytes, alignment);
+        }
+        cursor_ = (char*)(p + bytes);
+        return (void*)p;
+    }
+
+private:
+    friend class ScratchScope;
+
+    struct Page {
+        Page* next;
+        size_t size;
+    };
+
+    struct Mark {
+        Page* page;
+        char* cursor;
+    };
+
+    ScratchStack() = default;
+    ~ScratchStack();
+
+    Mark mark() const {
+        return {page_, cursor_};
+    }
+
+    void rewind(Mark const& mark) {
+        page_ = mark.page;
+        cursor_ = mark.cursor;
+        limit_ = page_ ? (char*)page_ + page_->size : nullptr;
+    }
+
+    GG_NO_INLINE void* allocateFromNextPage(size_t bytes, size_t alignment);
+
+    Page* firstPage_ = nullptr;
+    Page* page_ = nullptr;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+};
+
+// Everything allocated from the thread's ScratchStack during the scope's lifetime is released when it ends.
+class ScratchScope {
+public:
+    ScratchScope()
+        : stack_(ScratchStack::Get())
+        , mark_(stack_.mark()) {
+    }
+    ScratchScope(ScratchScope const&) = delete;
+    ~ScratchScope() {
+        stack_.rewind(mark_);
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        return stack_.allocate(bytes, alignment);
+    }
+
+    // (Elements are not destroyed, hence the restriction)
+    template<class T, class... T_Params>
+    T* newArray(size_t count, T_Params&&... params) {
+        static_assert(std::is_trivially_destructible<T>::value, "Scratch arrays are not destroyed");
+        return ConstructArray<T>(allocate(count * sizeof(T), alignof(T)), count, std::forward<T_Params>(params)...);
+    }
+
+private:
+    ScratchStack& stack_;
+    ScratchStack::Mark const mark_;
+};
+
+namespace Internal {
+
+template<class T_Allocator>
+auto TryExtendAllocationImpl(T_Allocator& allocator, void const* p, size_t bytes, int) -> decltype(allocator.tryExtend(p, bytes)) {
+    return allocator.tryExtend(p, bytes);
+}
+
+template<class T_Allocator>
+bool TryExtendAllocationImpl(T_Allocator&, void const*, size_t, long) {
+    return false;
+}
+
+template<class T, class T_Allocator>
+auto ReallocateArrayImpl(T_Allocator& allocator, T* data, size_t first, size_t count, size_t capacity, std::true_type, int)
+    -> decltype(allocator.reallocate(data, 0, 0, 0), (T*)nullptr) {
+    return (T*)allocator.reallocate(data, (first + count) * sizeof(T), capacity * sizeof(T), alignof(T));
+}
+
+template<class T, class T_Allocator, class T_Relocatable>
+T* ReallocateArrayImpl(T_Allocator& allocator, T* data, size_t first, size_t count, size_t capacity, T_Relocatable, long) {
+    T* const result = (T*)allocator.allocate(capacity * sizeof(T), alignof(T));
+    if (data) {     // (memcpy from null, even of nothing, lets the compiler drop the allocator's own null check)
+        RelocateArray<T>(result + first, count, data + first);
+        allocator.deallocate(data);
+    }
+    return result;
+}
+
+}
+
+// Grows the block at p to the given size without moving it, if the allocator knows how (optional tryExtend())
+template<class T_Allocator>
+bool TryExtendAllocation(T_Allocator& allocator, void const* p, size_t bytes) {
+    return Internal::TryExtendAllocationImpl(allocator, p, bytes, 0);
+}
+
+// Moves the elements [first, first+count) of data into a block with room for capacity elements, keeping their
+// indices. Tries tryExtend() first, then the allocator's optional reallocate(p, usedBytes, bytes, alignment)
+// if T is trivially relocatable, and otherwise allocates and relocates element by element.
+template<class T, class T_Allocator>
+T* ReallocateArray(T_Allocator& allocator, T* data, size_t first, size_t count, size_t capacity) {
+    if (data && TryExtendAllocation(allocator, data, capacity * sizeof(T))) {
+        return data;
+    }
+    using Relocatable = std::integral_constant<bool, IsTriviallyRelocatable<std::remove_const_t<T>>::value>;
+    return Internal::ReallocateArrayImpl<T>(allocator, data, first, count, capacity, Relocatable(), 0);
+}
+
 }
 
 #endif
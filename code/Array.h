@@ -17,6 +17,9 @@ public:
         : Array() {
         reserve(initialCapacity);
     }
+    explicit Array(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
     Array(Array&& src)
         : T_Allocator(std::move(src))
         , data_(std::exchange(src.data_, nullptr))
@@ -124,8 +127,9 @@ public:
 private:
     GG_NO_INLINE void grow(size_t requestedCapacity) {
         assert((unsigned)requestedCapacity > capacity_);
-        capacity_ = std::max(capacity_ * 2, (unsigned)requestedCapacity);
-        deallocate(std::exchange(data_, MoveArray<T>(allocate(capacity_ * sizeof(T), alignof(T)), count_, data_)));
+        unsigned const capacity = std::max(capacity_ * 2, (unsigned)requestedCapacity);
+        data_ = ReallocateArray<T, T_Allocator>(*this, data_, 0, count_, capacity);
+        capacity_ = capacity;
     }
 
     T* data_ = nullptr;
@@ -133,6 +137,10 @@ private:
     unsigned capacity_ = 0;
 };
 
+template<class T, class T_Allocator>
+struct IsTriviallyRelocatable<Array<T, T_Allocator>> : IsTriviallyRelocatable<T_Allocator> {
+};
+
 template<class T> template<class T_Allocator>
 Span<T>::Span(Array<std::remove_const_t<T>, T_Allocator> const& a)
     : first_(a.begin())
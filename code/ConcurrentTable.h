@@ -0,0 +1,203 @@
+#pragma once
+#ifndef GG_CONCURRENT_TABLE_H
+#define GG_CONCURRENT_TABLE_H
+
+#include "Allocator.h"
+#include "Hash.h"
+#include "EpochDomain.h"
+#include <mutex>
+
+namespace gg {
+
+// Read-mostly table: find() is wait-free and may run on any thread while writers (serialized by an internal
+// mutex) add and remove. Slots are atomic pointers to immutable entries, so a lookup never sees a half-written
+// key; growing publishes a new slot array and retires the old one through an EpochDomain.
+// Entries don't move, so a found value stays valid until it is removed (if removes can happen concurrently,
+// keep a ReadScope open while using it).
+template<class T_Key, class T_Value, class T_KeyTraits = HashKeyTraitsDefault<T_Key>, class T_Allocator = Mallocator>
+class ConcurrentTable : private T_Allocator {
+
+public:
+    using ReadScope = EpochDomain::ReadScope;
+
+    ConcurrentTable() = default;
+    explicit ConcurrentTable(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    ConcurrentTable(ConcurrentTable const&) = delete;
+
+    ~ConcurrentTable() {
+        if (Slots* const slots = slots_.load(std::memory_order_relaxed)) {
+            for (unsigned i = 0; i <= slots->mask; i++) {
+                Entry* const entry = slots->entries[i].load(std::memory_order_relaxed);
+                if (entry && entry != GetTombstone()) {
+                    releaseEntry(entry);
+                }
+            }
+            deallocate(slots);
+        }
+    }
+
+    unsigned count() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    // Wait-free
+    T_Value const* find(T_Key const& key) const {
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        ReadScope scope(epochs_);
+        Slots const* const slots = slots_.load();
+        if (!slots) {
+            return nullptr;
+        }
+        for (unsigned slot = hash & slots->mask; ; slot = (slot + 1) & slots->mask) {
+            Entry const* const entry = slots->entries[slot].load(std::memory_order_acquire);
+            if (!entry) {
+                return nullptr;
+            }
+            if (entry != GetTombstone() && entry->hash == hash && T_KeyTraits::Equals(entry->key, key)) {
+                return &entry->value;
+            }
+        }
+    }
+
+    // For ReadScope scope(table.getEpochDomain())
+    EpochDomain const& getEpochDomain() const {
+        return epochs_;
+    }
+
+    template<class... T_Params>
+    T_Value const* add(T_Key&& key, T_Params&&... params) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        assert(!find(key));     // Already in table, use findOrAdd()
+        return insert(T_KeyTraits::Hash(key), std::move(key), std::forward<T_Params>(params)...);
+    }
+
+    template<class... T_Params>
+    T_Value const* findOrAdd(T_Key&& key, T_Params&&... params) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        if (T_Value const* const found = find(key)) {
+            return found;
+        }
+        return insert(T_KeyTraits::Hash(key), std::move(key), std::forward<T_Params>(params)...);
+    }
+
+    // The entry is released once no reader can still be looking at it
+    bool remove(T_Key const& key) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        Slots* const slots = slots_.load(std::memory_order_relaxed);
+        if (!slots) {
+            return false;
+        }
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        for (unsigned slot = hash & slots->mask; ; slot = (slot + 1) & slots->mask) {
+            Entry* const entry = slots->entries[slot].load(std::memory_order_relaxed);
+            if (!entry) {
+                return false;
+            }
+            if (entry != GetTombstone() && entry->hash == hash && T_KeyTraits::Equals(entry->key, key)) {
+                slots->entries[slot].store(GetTombstone());    // (seq_cst, as for slots_ in grow())
+                count_.store(count_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                epochs_.retire(entry, ReleaseRetiredEntry, this);
+                epochs_.collect();
+                return true;
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        template<class... T_Params>
+        Entry(uint32_t hash, T_Key&& key, T_Params&&... params)
+            : hash(hash)
+            , key(std::move(key))
+            , value(std::forward<T_Params>(params)...) {
+        }
+        uint32_t const hash;
+        T_Key const key;
+        T_Value const value;
+    };
+
+    struct Slots {
+        unsigned mask;
+        std::atomic<Entry*> entries[1];     // (mask + 1 of them)
+    };
+
+    static Entry* GetTombstone() {
+        return (Entry*)alignof(Entry);
+    }
+
+    template<class... T_Params>
+    T_Value const* insert(uint32_t hash, T_Key&& key, T_Params&&... params) {
+        assert(!T_KeyTraits::IsNull(key));
+        Slots* slots = slots_.load(std::memory_order_relaxed);
+        if (!slots || 2 * (used_ + 1) > slots->mask + 1) {
+            slots = grow(slots);
+        }
+        Entry* const entry = ConstructInPlace<Entry>(allocate(sizeof(Entry), alignof(Entry)),
+            hash, std::move(key), std::forward<T_Params>(params)...);
+        unsigned slot = hash & slots->mask;
+        while (slots->entries[slot].load(std::memory_order_relaxed)) {
+            slot = (slot + 1) & slots->mask;
+        }
+        slots->entries[slot].store(entry, std::memory_order_release);
+        used_++;
+        count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return &entry->value;
+    }
+
+    // Copies live entries into a fresh array (dropping tombstones), publishes it and retires the old one
+    GG_NO_INLINE Slots* grow(Slots* oldSlots) {
+        unsigned const capacity = std::max(NextPow2(4 * (count_.load(std::memory_order_relaxed) + 1)), 16u);
+        size_t const bytes = sizeof(Slots) + (capacity - 1) * sizeof(std::atomic<Entry*>);
+        Slots* const slots = (Slots*)allocate(bytes, alignof(Slots));
+        slots->mask = capacity - 1;
+        for (unsigned i = 0; i < capacity; i++) {
+            ConstructInPlace<std::atomic<Entry*>>(slots->entries + i, nullptr);
+        }
+        used_ = 0;
+        if (oldSlots) {
+            for (unsigned i = 0; i <= oldSlots->mask; i++) {
+                Entry* const entry = oldSlots->entries[i].load(std::memory_order_relaxed);
+                if (entry && entry != GetTombstone()) {
+                    unsigned slot = entry->hash & slots->mask;
+                    while (slots->entries[slot].load(std::memory_order_relaxed)) {
+                        slot = (slot + 1) & slots->mask;
+                    }
+                    slots->entries[slot].store(entry, std::memory_order_relaxed);
+                    used_++;
+                }
+            }
+        }
+        // (seq_cst, pairs with the fence after the reader's epoch announcement, see EpochDomain::enter())
+        slots_.store(slots);
+        if (oldSlots) {
+            epochs_.retire(oldSlots, ReleaseRetiredSlots, this);
+            epochs_.collect();
+        }
+        return slots;
+    }
+
+    void releaseEntry(Entry* entry) {
+        entry->~Entry();
+        deallocate(entry);
+    }
+
+    static void ReleaseRetiredEntry(void* p, void* context) {
+        ((ConcurrentTable*)context)->releaseEntry((Entry*)p);
+    }
+
+    static void ReleaseRetiredSlots(void* p, void* context) {
+        ((ConcurrentTable*)context)->deallocate(p);
+    }
+
+    std::atomic<Slots*> slots_ = {nullptr};
+    std::atomic<unsigned> count_ = {0};
+    unsigned used_ = 0;     // (including tombstones, writer only)
+    std::mutex writeMutex_;
+    EpochDomain epochs_;
+};
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "EpochDomain.h"
+#include <cstdlib>
+
+namespace gg {
+
+// Threads get the lowest free index on first use and give it back when they exit. Only that first use runs the
+// compare-exchange loop (lock-free, not wait-free); after it, a thread's index is a plain thread_local read.
+static std::atomic<uint64_t> s_usedThreadIndices = {0};
+
+namespace {
+
+struct ThreadIndex {
+    ThreadIndex() {
+        uint64_t used = s_usedThreadIndices.load(std::memory_order_relaxed);
+        do {
+            if (~used == 0) {
+                // (in every build: the index would shift by 64 and point past EpochDomain::readers_)
+                assert(!"More than EpochDomain::cMaxThreads threads");
+                std::abort();
+            }
+            index = CountTrailingZeroBits(~used);
+        } while (!s_usedThreadIndices.compare_exchange_weak(used, used | (uint64_t)1 << index, std::memory_order_relaxed));
+    }
+    ~ThreadIndex() {
+        s_usedThreadIndices.fetch_and(~((uint64_t)1 << index), std::memory_order_relaxed);
+    }
+    unsigned index;
+};
+
+}
+
+unsigned EpochDomain::GetThreadIndex() {
+    static thread_local ThreadIndex threadIndex;
+    return threadIndex.index;
+}
+
+EpochDomain::~EpochDomain() {
+    for (Retired const& retired : retired_) {
+        retired.release(retired.p, retired.context);
+    }
+}
+
+void EpochDomain::enter() const {
+    Reader& reader = readers_[GetThreadIndex()];
+    if (reader.depth++ == 0) {
+        // The announcement must be ordered before this thread's loads of shared pointers, which may be plain
+        // acquires. A seq_cst store alone doesn't do that (store-buffering): the fence does, against the writer's
+        // seq_cst unlink and collect()'s seq_cst loads of the announcements. (On x86 the store already implies it.)
+        reader.epoch.store(epoch_.load());
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void EpochDomain::leave() const {
+    Reader& reader = readers_[GetThreadIndex()];
+    assert(reader.depth > 0);
+    if (--reader.depth == 0) {
+        reader.epoch.store(0, std::memory_order_release);
+    }
+}
+
+void EpochDomain::retire(void* p, void (*release)(void* p, void* context), void* context) {
+    retired_.addLast(Retired{epoch_.fetch_add(1), p, release, context});
+}
+
+void EpochDomain::collect() {
+    // Anything retired before the oldest epoch a reader is in can no longer be seen
+    uint64_t oldest = epoch_.load();
+    for (Reader const& reader : readers_) {
+        uint64_t const epoch = reader.epoch.load();
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    unsigned kept = 0;
+    for (Retired const& retired : retired_) {
+        if (retired.epoch < oldest) {
+            retired.release(retired.p, retired.context);
+        } else {
+            retired_[kept++] = retired;
+        }
+    }
+    retired_.setCount(kept);
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef GG_EPOCH_DOMAIN_H
+#define GG_EPOCH_DOMAIN_H
+
+#include "Array.h"
+#include <atomic>
+
+namespace gg {
+
+// Epoch-based reclamation: lets readers walk shared data without locks while a writer replaces parts of it.
+// Readers announce the epoch they started in (wait-free); memory the writer retires is only released once
+// every reader that could still see it has left. Writer-side calls must be serialized by the caller.
+// A thread's first enter() claims one of cMaxThreads reader slots with a short compare-exchange loop, and
+// aborts if none is left; later ones just reuse it.
+class EpochDomain {
+public:
+    enum { cMaxThreads = 64 };  // (threads alive at once that have read, across all domains; more aborts)
+
+    class ReadScope {
+    public:
+        explicit ReadScope(EpochDomain const& domain)
+            : domain_(domain) {
+            domain_.enter();
+        }
+        ReadScope(ReadScope const&) = delete;
+        ~ReadScope() {
+            domain_.leave();
+        }
+    private:
+        EpochDomain const& domain_;
+    };
+
+    EpochDomain() = default;
+    EpochDomain(EpochDomain const&) = delete;
+    ~EpochDomain();     // (releases everything still retired, so no reader may be left)
+
+    // Reader side, may nest
+    void enter() const;
+    void leave() const;
+
+    // Writer side. Memory must already be unreachable for new readers when retired.
+    void retire(void* p, void (*release)(void* p, void* context), void* context);
+    void collect();
+
+    unsigned getRetiredCount() const {
+        return retired_.count();
+    }
+
+private:
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> epoch;    // 0 while not reading
+        unsigned depth;                 // (only touched by the owning thread)
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        void* p;
+        void (*release)(void* p, void* context);
+        void* context;
+    };
+
+    static unsigned GetThreadIndex();
+
+    mutable Reader readers_[cMaxThreads] = {};
+    std::atomic<uint64_t> epoch_ = {1};
+    Array<Retired> retired_;
+};
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef GG_FRAME_RETIRED_ALLOCATOR_H
+#define GG_FRAME_RETIRED_ALLOCATOR_H
+
+#include "Allocator.h"
+
+namespace gg {
+
+// Bump allocator for CPU data that must outlive the GPU work submitted after it was allocated. Memory is carved
+// from chunks that remember the last fence value they were used under; a full chunk becomes reusable once the
+// tracker reports that fence value signalled. T_QueueTracker is anything shaped like vk::QueueTracker (e.g. a fake).
+template<class T_QueueTracker, class T_Allocator = Mallocator>
+class FrameRetiredAllocator : private T_Allocator {
+public:
+    using FenceValue = typename T_QueueTracker::FenceValue;
+
+    enum { cDefaultChunkSize = 64 * 1024 };
+
+    explicit FrameRetiredAllocator(T_QueueTracker const& tracker, size_t chunkSize = cDefaultChunkSize)
+        : tracker_(tracker)
+        , chunkSize_(chunkSize) {
+    }
+    FrameRetiredAllocator(FrameRetiredAllocator const&) = delete;
+
+    // The tracker should have waited for everything by now (see QueueTracker::waitForAll())
+    ~FrameRetiredAllocator() {
+        releaseList(current_);
+        releaseList(std::exchange(retiredFirst_, nullptr));
+        releaseList(std::exchange(free_, nullptr));
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        uintptr_t const p = ((uintptr_t)cursor_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (p + bytes > (uintptr_t)limit_ || !limit_) {
+            return allocateFromNextChunk(bytes, alignment);
+        }
+        cursor_ = (char*)(p + bytes);
+        current_->fenceValue = tracker_.unsubmittedFenceValue();
+        return (void*)p;
+    }
+
+    // (Memory is reclaimed by fence, not by deallocation)
+    void deallocate(void const*) {
+    }
+
+    // Makes chunks whose fence value has been signalled available again. Called whenever a chunk runs out.
+    void recycleSignalled() {
+        while (retiredFirst_ && tracker_.fenceValueIsSignalled(retiredFirst_->fenceValue)) {
+            Chunk* const chunk = std::exchange(retiredFirst_, retiredFirst_->next);
+            if (chunk->size == chunkSize_) {
+                chunk->next = std::exchange(free_, chunk);
+            } else {
+                T_Allocator::deallocate(chunk);     // (oversized, for a single large allocation)
+            }
+        }
+        if (!retiredFirst_) {
+            retiredLast_ = nullptr;
+        }
+    }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+        FenceValue fenceValue;
+    };
+
+    GG_NO_INLINE void* allocateFromNextChunk(size_t bytes, size_t alignment) {
+        if (current_) {
+            // Retire in fence order: chunks are only ever tagged with the latest fence value
+            current_->next = nullptr;
+            (retiredLast_ ? retiredLast_->next : retiredFirst_) = current_;
+            retiredLast_ = current_;
+        }
+        recycleSignalled();
+        size_t const needed = sizeof(Chunk) + alignment + bytes;
+        if (free_ && needed <= chunkSize_) {
+            current_ = std::exchange(free_, free_->next);
+        } else {
+            size_t const size = needed <= chunkSize_ ? chunkSize_ : needed;
+            current_ = (Chunk*)T_Allocator::allocate(size, alignof(Chunk));
+            current_->size = size;
+        }
+        current_->next = nullptr;
+        cursor_ = (char*)(current_ + 1);
+        limit_ = (char*)current_ + current_->size;
+        return allocate(bytes, alignment);
+    }
+
+    void releaseList(Chunk* chunk) {
+        while (chunk) {
+            T_Allocator::deallocate(std::exchange(chunk, chunk->next));
+        }
+    }
+
+    T_QueueTracker const& tracker_;
+    size_t const chunkSize_;
+    Chunk* current_ = nullptr;
+    Chunk* retiredFirst_ = nullptr;
+    Chunk* retiredLast_ = nullptr;
+    Chunk* free_ = nullptr;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+};
+
+}
+
+#endif
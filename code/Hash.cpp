@@ -0,0 +1,305 @@
+#include "Hash.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#include <immintrin.h>
+#define GG_HASH_X86 1
+#endif
+
+namespace gg {
+
+namespace {
+
+// Stripe keys (0-7) and scramble keys (8-15), arbitrary 64-bit constants
+uint64_t const s_keys[16] = {
+    0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+    0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+    0xcb00c391bb52283cull, 0xa32e531b8b65d088ull, 0x4ef90da297486471ull, 0xd8acdea946ef1938ull,
+    0x3f349ce33f76faa8ull, 0x1d4f0bc7c7bbdcf9ull, 0x3159b4cd4be0518aull, 0x647378d9c97e9fc8ull,
+};
+
+uint64_t const cPrime64 = 0x9e3779b97f4a7c15ull;
+uint32_t const cScramblePrime = 0x9e3779b1;
+
+enum {
+    cStripeBytes = 64,
+    cStripesPerScramble = 16,
+    cMaxShortBytes = 64,
+};
+
+uint64_t Load64(uint8_t const* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t Load32(uint8_t const* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 64x64->128 multiply, folded
+uint64_t MultiplyFold(uint64_t a, uint64_t b) {
+#if defined(_M_X64)
+    uint64_t high;
+    uint64_t const low = _umul128(a, b, &high);
+    return low ^ high;
+#elif defined(_M_ARM64)
+    return (a * b) ^ __umulh(a, b);
+#else
+    uint64_t const aLow = (uint32_t)a, aHigh = a >> 32, bLow = (uint32_t)b, bHigh = b >> 32;
+    uint64_t const lowLow = aLow * bLow, lowHigh = aLow * bHigh, highLow = aHigh * bLow;
+    uint64_t const middle = (lowLow >> 32) + (uint32_t)lowHigh + (uint32_t)highLow;
+    uint64_t const high = aHigh * bHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    return (a * b) ^ high;
+#endif
+}
+
+uint64_t Avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919e3779f9ull;
+    return h ^ (h >> 32);
+}
+
+// Up to 64 bytes: one or a few 128-bit multiplies, reading each byte once
+uint64_t ShortHash64(uint8_t const* data, size_t size, uint64_t seed) {
+    uint64_t h = seed ^ s_keys[0] ^ (size * cPrime64);
+    if (size <= 16) {
+        uint64_t a = 0, b = 0;
+        if (size >= 4) {
+            size_t const middle = (size >> 3) << 2;
+            a = ((uint64_t)Load32(data) << 32) | Load32(data + size - 4);
+            b = ((uint64_t)Load32(data + middle) << 32) | Load32(data + size - 4 - middle);
+        } else if (size) {
+            a = ((uint64_t)data[0] << 16) | ((uint64_t)data[size >> 1] << 8) | data[size - 1];
+        }
+        h = MultiplyFold(a ^ s_keys[1], b ^ h);
+    } else {
+        // 16-byte chunks, the last one overlapping the one before
+        for (size_t i = 0; i + 16 < size; i += 16) {
+            h = MultiplyFold(Load64(data + i) ^ s_keys[2 + i / 16], Load64(data + i + 8) ^ h);
+        }
+        h = MultiplyFold(Load64(data + size - 16) ^ s_keys[6], Load64(data + size - 8) ^ h);
+    }
+    return Avalanche(h ^ MultiplyFold(h ^ s_keys[7], size ^ cPrime64));
+}
+
+// Long inputs: 8 64-bit lanes. Per stripe, lane i adds the low * high halves of (data ^ key) and its neighbour
+// lane's data; every 16 stripes the lanes are scrambled. The vector versions compute exactly the same thing.
+void AccumulateScalar(uint64_t* acc, uint8_t const* stripe) {
+    for (unsigned i = 0; i < 8; i++) {
+        uint64_t const data = Load64(stripe + 8 * i);
+        uint64_t const keyed = data ^ s_keys[i];
+        acc[i ^ 1] += data;
+        acc[i] += (keyed & 0xffffffff) * (keyed >> 32);
+    }
+}
+
+void ScrambleScalar(uint64_t* acc) {
+    for (unsigned i = 0; i < 8; i++) {
+        acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ s_keys[8 + i]) * cScramblePrime;
+    }
+}
+
+#if GG_HASH_X86
+
+void AccumulateSse2(uint64_t* acc, uint8_t const* stripe) {
+    for (unsigned i = 0; i < 8; i += 2) {
+        __m128i const data = _mm_loadu_si128((__m128i const*)(stripe + 8 * i));
+        __m128i const keyed = _mm_xor_si128(data, _mm_loadu_si128((__m128i const*)(s_keys + i)));
+        __m128i const product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+        __m128i const swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        __m128i* const lanes = (__m128i*)(acc + i);
+        _mm_storeu_si128(lanes, _mm_add_epi64(_mm_loadu_si128(lanes), _mm_add_epi64(product, swapped)));
+    }
+}
+
+void ScrambleSse2(uint64_t* acc) {
+    __m128i const prime = _mm_set1_epi32((int)cScramblePrime);
+    for (unsigned i = 0; i < 8; i += 2) {
+        __m128i* const lanes = (__m128i*)(acc + i);
+        __m128i x = _mm_loadu_si128(lanes);
+        x = _mm_xor_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 47)), _mm_loadu_si128((__m128i const*)(s_keys + 8 + i)));
+        __m128i const low = _mm_mul_epu32(x, prime);
+        __m128i const high = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+        _mm_storeu_si128(lanes, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+    }
+}
+
+void AccumulateAvx2(uint64_t* acc, uint8_t const* stripe) {
+    for (unsigned i = 0; i < 8; i += 4) {
+        __m256i const data = _mm256_loadu_si256((__m256i const*)(stripe + 8 * i));
+        __m256i const keyed = _mm256_xor_si256(data, _mm256_loadu_si256((__m256i const*)(s_keys + i)));
+        __m256i const product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+        __m256i const swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        __m256i* const lanes = (__m256i*)(acc + i);
+        _mm256_storeu_si256(lanes, _mm256_add_epi64(_mm256_loadu_si256(lanes), _mm256_add_epi64(product, swapped)));
+    }
+}
+
+void ScrambleAvx2(uint64_t* acc) {
+    __m256i const prime = _mm256_set1_epi32((int)cScramblePrime);
+    for (unsigned i = 0; i < 8; i += 4) {
+        __m256i* const lanes = (__m256i*)(acc + i);
+        __m256i x = _mm256_loadu_si256(lanes);
+        x = _mm256_xor_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 47)), _mm256_loadu_si256((__m256i const*)(s_keys + 8 + i)));
+        __m256i const low = _mm256_mul_epu32(x, prime);
+        __m256i const high = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), prime);
+        _mm256_storeu_si256(lanes, _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+    }
+}
+
+#endif
+
+template<void T_Accumulate(uint64_t*, uint8_t const*), void T_Scramble(uint64_t*)>
+uint64_t LongHash64(void const* buffer, size_t size, uint64_t seed) {
+    uint8_t const* const data = (uint8_t const*)buffer;
+    if (size <= cMaxShortBytes) {
+        return ShortHash64(data, size, seed);
+    }
+    uint64_t acc[8];
+    for (unsigned i = 0; i < 8; i++) {
+        acc[i] = s_keys[15 - i] ^ seed;
+    }
+    // Whole stripes, except that the last (possibly partial) one is taken from the final 64 bytes
+    size_t const stripeCount = (size - 1) / cStripeBytes;
+    for (size_t i = 0; i < stripeCount; i++) {
+        T_Accumulate(acc, data + i * cStripeBytes);
+        if (i % cStripesPerScramble == cStripesPerScramble - 1) {
+            T_Scramble(acc);
+        }
+    }
+    T_Accumulate(acc, data + size - cStripeBytes);
+
+    uint64_t h = (size * cPrime64) ^ seed;
+    for (unsigned i = 0; i < 8; i += 2) {
+        h += MultiplyFold(acc[i] ^ s_keys[8 + i], acc[i + 1] ^ s_keys[9 + i]);
+    }
+    return Avalanche(h);
+}
+
+// CRC32C (Castagnoli, reflected)
+uint32_t Crc32cSoftware(void const* buffer, size_t size, uint32_t crc) {
+    struct Table {
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (unsigned bit = 0; bit < 8; bit++) {
+                    c = (c >> 1) ^ (0x82f63b78 & (0 - (c & 1)));
+                }
+                entries[i] = c;
+            }
+        }
+        uint32_t entries[256];
+    };
+    static Table const s_table;
+
+    uint8_t const* const data = (uint8_t const*)buffer;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ s_table.entries[(crc ^ data[i]) & 0xff];
+    }
+    return ~crc;
+}
+
+#if GG_HASH_X86
+
+uint32_t Crc32cSse42(void const* buffer, size_t size, uint32_t crc) {
+    uint8_t const* data = (uint8_t const*)buffer;
+    uint8_t const* const end = data + size;
+    crc = ~crc;
+#if defined(_M_X64)
+    uint64_t crc64 = crc;
+    for (; end - data >= 8; data += 8) {
+        crc64 = _mm_crc32_u64(crc64, Load64(data));
+    }
+    crc = (uint32_t)crc64;
+#endif
+    for (; end - data >= 4; data += 4) {
+        crc = _mm_crc32_u32(crc, Load32(data));
+    }
+    for (; data != end; data++) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return ~crc;
+}
+
+struct CpuFeatures {
+    CpuFeatures() {
+        int info[4];
+        __cpuid(info, 0);
+        int const maxLeaf = info[0];
+        __cpuid(info, 1);
+        sse42 = (info[2] & (1 << 20)) != 0;
+        // AVX2 also needs the OS to save ymm registers (OSXSAVE, then XCR0 bits 1 and 2)
+        bool const osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+        if (maxLeaf >= 7 && osSavesYmm) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    }
+    bool sse42 = false;
+    bool avx2 = false;
+};
+
+CpuFeatures const& GetCpuFeatures() {
+    static CpuFeatures const s_features;
+    return s_features;
+}
+
+#endif
+
+using Hash64Function = uint64_t (*)(void const*, size_t, uint64_t);
+using Crc32cFunction = uint32_t (*)(void const*, size_t, uint32_t);
+
+#ifndef NDEBUG
+// The vector paths must give exactly the scalar result (over every size up to a few scrambles), or hashes
+// would depend on the machine
+void CheckHash64(Hash64Function hash) {
+    uint8_t data[cStripeBytes * cStripesPerScramble * 2 + 37];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)Avalanche(i);
+    }
+    for (size_t size = 0; size <= sizeof(data); size++) {
+        assert(hash(data, size, size) == (LongHash64<AccumulateScalar, ScrambleScalar>(data, size, size)));
+    }
+}
+#endif
+
+Hash64Function SelectHash64() {
+#if GG_HASH_X86
+    Hash64Function const hash = GetCpuFeatures().avx2
+        ? LongHash64<AccumulateAvx2, ScrambleAvx2>
+        : LongHash64<AccumulateSse2, ScrambleSse2>;
+#else
+    Hash64Function const hash = LongHash64<AccumulateScalar, ScrambleScalar>;
+#endif
+#ifndef NDEBUG
+    CheckHash64(hash);
+#endif
+    return hash;
+}
+
+Crc32cFunction SelectCrc32c() {
+#if GG_HASH_X86
+    if (GetCpuFeatures().sse42) {
+        return Crc32cSse42;
+    }
+#endif
+    return Crc32cSoftware;
+}
+
+}
+
+uint64_t BufferHash64(void const* buffer, size_t size, uint64_t seed) {
+    static Hash64Function const s_hash = SelectHash64();
+    return s_hash(buffer, size, seed);
+}
+
+uint32_t BufferCrc32c(void const* buffer, size_t size, uint32_t crc) {
+    static Crc32cFunction const s_crc32c = SelectCrc32c();
+    return s_crc32c(buffer, size, crc);
+}
+
+}
@@ -57,9 +57,16 @@ inline uint32_t CombineHash32(uint32_t a, uint32_t b) {
 uint32_t BufferHash32(void const* buffer, size_t size, uint32_t seed = 0xdecafbad);
 uint32_t BufferHash32(Span<int8_t const> const& data, uint32_t seed = 0xdecafbad);
 uint32_t StringHash32(char const* str, uint32_t seed = 0xdecafbad);
+constexpr uint32_t ConstStringHash32(char const* chars, size_t length, uint32_t seed = 0xdecafbad);
+
+// For large buffers (pixels, long paths): 64 bytes per step, vectorized with the best instruction set found at
+// runtime. Gives the same result on every machine. (Hash.cpp)
+uint64_t BufferHash64(void const* buffer, size_t size, uint64_t seed = 0xdecafbad);
+// CRC32C (Castagnoli), with the SSE4.2 instruction when available. Pass a previous result to continue it.
+uint32_t BufferCrc32c(void const* buffer, size_t size, uint32_t crc = 0);
 
 struct HashedString {
-    HashedString()
+    constexpr HashedString()
         : hash(0)
         , chars(nullptr) {
     }
@@ -67,6 +74,10 @@ struct HashedString {
         : hash(StringHash32(chars))
         , chars(chars) {
     }
+    constexpr HashedString(uint32_t hash, char const* chars)
+        : hash(hash)
+        , chars(chars) {
+    }
     bool operator==(HashedString const& b) const {
         return hash == b.hash && strcmp(chars, b.chars) == 0;
     }
@@ -81,8 +92,43 @@ struct HashedString {
     char const* chars;
 };
 
+namespace Internal {
+
+// Murmurhash3 rounds, as single expressions so they are constexpr in C++11 terms too (v140)
+constexpr uint32_t HashRotateLeft(uint32_t bits, unsigned shift) {
+    return (bits << shift) | (bits >> (32 - shift));
+}
+
+constexpr uint32_t HashScrambleBlock(uint32_t k1) {
+    return HashRotateLeft(k1 * 0xcc9e2d51, 15) * 0x1b873593;
+}
+
+constexpr uint32_t HashAddBlock(uint32_t h1, uint32_t k1) {
+    return HashRotateLeft(h1 ^ HashScrambleBlock(k1), 13) * 5 + 0xe6546b64;
+}
+
+// Little-endian, like the block loads at run time
+constexpr uint32_t HashLoadBytes(char const* chars, size_t count) {
+    return count ? (uint8_t)chars[0] | HashLoadBytes(chars + 1, count - 1) << 8 : 0;
+}
+
+constexpr uint32_t HashAddBlocks(uint32_t h1, char const* chars, size_t blockCount) {
+    return blockCount ? HashAddBlocks(HashAddBlock(h1, HashLoadBytes(chars, 4)), chars + 4, blockCount - 1) : h1;
+}
+
+constexpr uint32_t HashAddTail(uint32_t h1, char const* tail, size_t count) {
+    return count ? h1 ^ HashScrambleBlock(HashLoadBytes(tail, count)) : h1;
+}
+
+// Same as MixBits32 (minus its assert)
+constexpr uint32_t HashFinalMix(uint32_t h1) {
+    return (uint32_t)(((uint64_t)h1 * 11400714819323198549ull) >> 32);
+}
+
+}
+
 GG_NO_INLINE inline uint32_t BufferHash32(void const* buffer, size_t size, uint32_t seed) {
-    // Murmurhash3 with cheaper final mixing
+    // Murmurhash3 with cheaper final mixing (ConstStringHash32 must give the same results)
 
     int8_t const*const data = (int8_t*)buffer;
     unsigned const length = (unsigned)size;
@@ -90,19 +136,10 @@ GG_NO_INLINE inline uint32_t BufferHash32(void const* buffer, size_t size, uint3
 
     uint32_t h1 = seed;
 
-    uint32_t const c1 = 0xcc9e2d51;
-    uint32_t const c2 = 0x1b873593;
-
     uint32_t const* blocks = (uint32_t const*)(data + blockCount * 4);
 
     for (int i = -blockCount; i; i++) {
-        uint32_t k1 = blocks[i];
-        k1 *= c1;
-        k1 = RotateBitsLeft(k1, 15);
-        k1 *= c2;
-        h1 ^= k1;
-        h1 = RotateBitsLeft(h1, 13);
-        h1 = h1 * 5 + 0xe6546b64;
+        h1 = Internal::HashAddBlock(h1, blocks[i]);
     }
 
     uint8_t const* tail = (uint8_t const*)(data + blockCount * 4);
@@ -113,15 +150,27 @@ GG_NO_INLINE inline uint32_t BufferHash32(void const* buffer, size_t size, uint3
     case 3: k1 ^= tail[2] << 16;
     case 2: k1 ^= tail[1] << 8;
     case 1: k1 ^= tail[0];
-        k1 *= c1;
-        k1 = RotateBitsLeft(k1, 15);
-        k1 *= c2;
-        h1 ^= k1;
+        h1 ^= Internal::HashScrambleBlock(k1);
     };
 
     return MixBits32(h1 ^ length);
 }
 
+// BufferHash32 of a string, usable at compile time
+constexpr uint32_t ConstStringHash32(char const* chars, size_t length, uint32_t seed) {
+    return Internal::HashFinalMix(Internal::HashAddTail(Internal::HashAddBlocks(seed, chars, length / 4),
+        chars + length / 4 * 4, length & 3) ^ (uint32_t)length);
+}
+
+// "name"_hs is a HashedString equal to HashedString("name"), with the hash computed at compile time when
+// used in a constant expression. GG_HASHED("name") always is.
+constexpr HashedString operator"" _hs(char const* chars, size_t length) {
+    return HashedString(ConstStringHash32(chars, length), chars);
+}
+
+#define GG_HASHED(literal) \
+    gg::HashedString(std::integral_constant<uint32_t, gg::ConstStringHash32(literal, sizeof(literal) - 1)>::value, literal)
+
 inline uint32_t StringHash32(char const* data, uint32_t seed) {
     return BufferHash32(data, strlen(data), seed);
 }
@@ -0,0 +1,262 @@
+#pragma once
+#ifndef GG_HASH_PROBING_H
+#define GG_HASH_PROBING_H
+
+#include "MiscUtil.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GG_CONTROL_GROUP_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define GG_CONTROL_GROUP_NEON 1
+#endif
+
+namespace gg {
+
+// Probing policies for Table and Set.
+
+// Open addressing with backward-shift deletion, at most half full. Probes compare full keys.
+struct LinearProbing {
+    enum { cCacheHashes = 0, cRobinHood = 0, cMaxLoadEighths = 4 };
+};
+
+// LinearProbing that also stores each slot's 32-bit hash: growing and deletion never rehash keys,
+// and probes only compare keys whose hashes match. For keys that are expensive to hash or compare.
+struct LinearProbingCachedHashes {
+    enum { cCacheHashes = 1, cRobinHood = 0, cMaxLoadEighths = 4 };
+};
+
+// Linear probing where an insert displaces entries that are closer to their home slot than it is, which keeps
+// clusters ordered by home slot. That bounds probe length variance, lets failed lookups stop early, and allows
+// up to 7/8 full. Hashes are cached, so displacement distances are cheap.
+struct RobinHoodProbing {
+    enum { cCacheHashes = 1, cRobinHood = 1, cMaxLoadEighths = 7 };
+};
+
+// A separate array of control bytes (7 bits of hash per slot) is matched 16 slots at a time,
+// so keys are only touched on tag hits. Deletion leaves tombstones; up to 7/8 full.
+struct GroupProbing {
+};
+
+// Table only: growing moves a few slots per add/remove from the old array to the new one, instead of rehashing
+// everything in one call. Both arrays use T_Inner, which must be one of the linear policies.
+template<class T_Inner = LinearProbing>
+struct IncrementalProbing {
+};
+
+// Table only (see DenseTable): keys and values are packed in arrays, and a separate linear-probing index of
+// 32-bit slots points into them. Iteration only touches the packed values, but each lookup pays an extra
+// indirection from slot to entry; removal moves the last entry into the hole.
+struct DenseProbing {
+};
+
+// Probe lengths of a linear-probing Table or Set, for tuning hashes and load factors on real data
+struct ProbeStats {
+    enum { cHistogramBuckets = 16 };
+
+    unsigned count;
+    unsigned capacity;
+    unsigned maxProbeLength;        // (a lookup that finds the entry in its home slot has length 1)
+    float averageProbeLength;
+    unsigned clusterHistogram[cHistogramBuckets];   // [i]: runs of full slots with length in [2^i, 2^(i+1))
+
+    float loadFactor() const {
+        return capacity ? (float)count / capacity : 0.f;
+    }
+};
+
+namespace Internal {
+
+// Base of the linear-probing Table and Set: their allocator, plus the slot hashes array if the policy caches
+// them. Without, it adds nothing, so those tables keep their size; it sits on top of the allocator rather than
+// beside it because MSVC only folds away one empty base.
+template<class T_Allocator, bool T_CacheHashes>
+class LinearProbingBase : public T_Allocator {
+public:
+    LinearProbingBase() = default;
+    explicit LinearProbingBase(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    LinearProbingBase(LinearProbingBase&& src)
+        : T_Allocator(std::move(src))
+        , hashes_(std::exchange(src.hashes_, nullptr)) {
+    }
+
+    uint32_t* hashes_ = nullptr;
+};
+
+template<class T_Allocator>
+class LinearProbingBase<T_Allocator, false> : public T_Allocator {
+public:
+    LinearProbingBase() = default;
+    explicit LinearProbingBase(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    LinearProbingBase(LinearProbingBase&& src)
+        : T_Allocator(std::move(src)) {
+    }
+
+    static uint32_t* hashes_;   // (only named by code that cCacheHashes turns off, so never touched)
+};
+
+template<class T_Allocator>
+uint32_t* LinearProbingBase<T_Allocator, false>::hashes_ = nullptr;
+
+// getHomeSlot(slot) gives a full slot's home slot (its hash & mask)
+template<class T_IsFull, class T_GetHomeSlot>
+ProbeStats GetLinearProbeStats(unsigned count, unsigned mask, T_IsFull isFull, T_GetHomeSlot getHomeSlot) {
+    ProbeStats stats = {};
+    stats.count = count;
+    stats.capacity = count ? mask + 1 : 0;
+    if (!count) {
+        return stats;
+    }
+    // Start after an empty slot, so no cluster is split by the wrap-around
+    unsigned start = 0;
+    while (isFull(start)) {
+        start = (start + 1) & mask;
+    }
+    uint64_t totalProbeLength = 0;
+    unsigned clusterLength = 0;
+    for (unsigned i = 1; i <= mask + 1; i++) {
+        unsigned const slot = (start + i) & mask;
+        if (isFull(slot)) {
+            unsigned const probeLength = ((slot - getHomeSlot(slot)) & mask) + 1;
+            totalProbeLength += probeLength;
+            stats.maxProbeLength = std::max(stats.maxProbeLength, probeLength);
+            clusterLength++;
+        } else if (clusterLength) {
+            stats.clusterHistogram[std::min(FloorLog2(clusterLength), (unsigned)ProbeStats::cHistogramBuckets - 1)]++;
+            clusterLength = 0;
+        }
+    }
+    stats.averageProbeLength = (float)((double)totalProbeLength / count);
+    return stats;
+}
+
+enum : uint8_t {
+    cControlEmpty = 0x80,
+    cControlDeleted = 0xfe,     // (full slots hold a tag in 0..0x7f)
+};
+
+inline uint8_t GetControlTag(uint32_t hash) {
+    return (uint8_t)(hash >> 25);
+}
+
+// 16 control bytes, loaded from a 16-aligned address. Matches come back as one bit per slot.
+class ControlGroup {
+public:
+    enum { cSlots = 16 };
+
+#if GG_CONTROL_GROUP_SSE2
+    explicit ControlGroup(uint8_t const* controls)
+        : controls_(_mm_load_si128((__m128i const*)controls)) {
+    }
+    uint32_t match(uint8_t control) const {
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(controls_, _mm_set1_epi8((char)control)));
+    }
+    uint32_t matchEmptyOrDeleted() const {
+        return (uint32_t)_mm_movemask_epi8(controls_);
+    }
+private:
+    __m128i controls_;
+#elif GG_CONTROL_GROUP_NEON
+    explicit ControlGroup(uint8_t const* controls)
+        : controls_(vld1q_u8(controls)) {
+    }
+    uint32_t match(uint8_t control) const {
+        return MoveMask(vceqq_u8(controls_, vdupq_n_u8(control)));
+    }
+    uint32_t matchEmptyOrDeleted() const {
+        return MoveMask(vcltq_s8(vreinterpretq_s8_u8(controls_), vdupq_n_s8(0)));
+    }
+private:
+    static uint32_t MoveMask(uint8x16_t lanes) {
+        static uint8_t const weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t const bits = vandq_u8(lanes, vld1q_u8(weights));
+        return vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+    }
+    uint8x16_t controls_;
+#else
+    explicit ControlGroup(uint8_t const* controls)
+        : controls_(controls) {
+    }
+    uint32_t match(uint8_t control) const {
+        uint32_t bits = 0;
+        for (unsigned i = 0; i < cSlots; i++) {
+            bits |= (uint32_t)(controls_[i] == control) << i;
+        }
+        return bits;
+    }
+    uint32_t matchEmptyOrDeleted() const {
+        uint32_t bits = 0;
+        for (unsigned i = 0; i < cSlots; i++) {
+            bits |= (uint32_t)(controls_[i] >> 7) << i;
+        }
+        return bits;
+    }
+private:
+    uint8_t const* controls_;
+#endif
+
+public:
+    uint32_t matchEmpty() const {
+        return match(cControlEmpty);
+    }
+};
+
+// Slots are probed a group at a time, stepping through groups by triangular numbers (visits every group)
+class GroupProbeSequence {
+public:
+    GroupProbeSequence(uint32_t hash, unsigned mask)
+        : groupMask_(mask / ControlGroup::cSlots)
+        , group_(hash & groupMask_) {
+    }
+    unsigned offset() const {
+        return group_ * ControlGroup::cSlots;
+    }
+    void next() {
+        group_ = (group_ + ++step_) & groupMask_;
+        assert(step_ <= groupMask_ + 1);    // (always some empty slot, so lookups terminate)
+    }
+private:
+    unsigned groupMask_;
+    unsigned group_;
+    unsigned step_ = 0;
+};
+
+// At most 7/8 of the slots may be used (full or deleted)
+inline unsigned GetGroupProbingMaxUsed(unsigned capacity) {
+    return capacity - capacity / 8;
+}
+
+inline unsigned GetGroupProbingCapacity(size_t count) {
+    unsigned const needed = (unsigned)(count + (count + 6) / 7);
+    return std::max(NextPow2(needed), (unsigned)ControlGroup::cSlots);
+}
+
+// Finds a slot for a key known not to be present
+inline unsigned FindGroupInsertSlot(uint8_t const* controls, unsigned mask, uint32_t hash) {
+    for (GroupProbeSequence seq(hash, mask); ; seq.next()) {
+        uint32_t const free = ControlGroup(controls + seq.offset()).matchEmptyOrDeleted();
+        if (free) {
+            return seq.offset() + CountTrailingZeroBits(free);
+        }
+    }
+}
+
+// Marks a slot free again. A group that still has an empty slot never made a probe continue past it,
+// so the slot can go straight back to empty instead of becoming a tombstone. Returns whether it did.
+inline bool ReleaseGroupSlot(uint8_t* controls, unsigned slot) {
+    unsigned const groupOffset = slot & ~(unsigned)(ControlGroup::cSlots - 1);
+    bool const empty = ControlGroup(controls + groupOffset).matchEmpty() != 0;
+    controls[slot] = empty ? cControlEmpty : cControlDeleted;
+    return empty;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+#pragma once
+#ifndef GG_INLINE_ARRAY_H
+#define GG_INLINE_ARRAY_H
+
+#include "Allocator.h"
+#include "Span.h"
+#include "MiscUtil.h"
+
+namespace gg {
+
+// Array that stores up to N elements inside itself, and only goes to the allocator beyond that.
+// (No pointer to its own storage is kept, so it relocates as well as its elements do.)
+template<class T, unsigned N, class T_Allocator = Mallocator>
+class InlineArray : private T_Allocator {
+
+public:
+    InlineArray() = default;
+    explicit InlineArray(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    InlineArray(InlineArray&& src)
+        : T_Allocator(std::move(src))
+        , count_(std::exchange(src.count_, 0))
+        , capacity_(std::exchange(src.capacity_, N)) {
+        if (capacity_ > N) {
+            heap_ = src.heap_;
+        } else {
+            RelocateArray<T>(inline_, count_, (T*)src.inline_);
+        }
+    }
+    InlineArray(Span<T const> span) {
+        addLastCopiedSpan(span);
+    }
+
+    ~InlineArray() {
+        removeAll();
+        if (capacity_ > N) {
+            deallocate(heap_);
+        }
+    }
+
+    InlineArray& operator=(InlineArray&& src) {
+        ReconstructInPlace(*this, std::move(src));
+        return *this;
+    }
+
+    T& addLast(T const& source) {
+        return *ConstructInPlace<T>(emplaceLast(1), source);
+    }
+
+    T& addLast(T&& source) {
+        return *ConstructInPlace<T>(emplaceLast(1), std::move(source));
+    }
+
+    template<class... T_Params>
+    T& addLast(T_Params&&... params) {
+        return *ConstructInPlace<T>(emplaceLast(1), std::forward<T_Params>(params)...);
+    }
+
+    T* addLastN(size_t n) {
+        return ConstructArray<T>(emplaceLast(n), n);
+    }
+
+    T* addLastCopiedSpan(Span<T const> span) {
+        return CopyConstructArray<T>(emplaceLast(span.count()), span.count(), span.begin());
+    }
+
+    T* addLastMovedSpan(Span<T>&& span) {
+        Span<T> temp = std::move(span);
+        return MoveArray<T>(emplaceLast(temp.count()), temp.count(), temp.begin());
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity);
+        }
+    }
+
+    void* emplaceLast(size_t n) {
+        reserve(count_ + n);
+        return (std::remove_const_t<T>*)begin() + std::exchange(count_, count_ + (unsigned)n);
+    }
+
+    T removeLast() {
+        assert(count_ > 0);
+        return std::move(begin()[--count_]);
+    }
+
+    void removeLastN(size_t n) {
+        assert(count_ >= n);
+        T* const data = begin();
+        for (size_t i = 0; i < n; i++) {
+            data[count_ - i - 1].~T();
+        }
+        count_ -= (unsigned)n;
+    }
+
+    void removeAll() {
+        removeLastN(count_);
+    }
+
+    void setCount(size_t count) {
+        if (count < count_) {
+            removeLastN(count_ - count);
+        } else {
+            emplaceLast(count - count_);
+        }
+    }
+
+    bool isInline() const {
+        return capacity_ == N;
+    }
+
+    T* begin() const {
+        return capacity_ > N ? heap_ : (T*)inline_;
+    }
+
+    T* end() const {
+        return begin() + count_;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    T& operator[](size_t i) const {
+        assert(i < count_);
+        return begin()[i];
+    }
+
+    Span<T> slice(size_t start, size_t end) const {
+        assert(start <= end && end <= count_);
+        return {begin() + start, end - start};
+    }
+
+    operator Span<T>() const {
+        return {begin(), count_};
+    }
+
+    // (Only for mutable T, where it differs from the one above)
+    template<class T_Elem = T, class = std::enable_if_t<!std::is_const<T_Elem>::value>>
+    operator Span<T const>() const {
+        return {begin(), count_};
+    }
+
+private:
+    GG_NO_INLINE void grow(size_t requestedCapacity) {
+        assert((unsigned)requestedCapacity > capacity_);
+        unsigned const capacity = std::max(capacity_ * 2, (unsigned)requestedCapacity);
+        if (capacity_ > N) {
+            heap_ = ReallocateArray<T, T_Allocator>(*this, heap_, 0, count_, capacity);
+        } else {
+            T* const heap = (T*)allocate(capacity * sizeof(T), alignof(T));
+            heap_ = RelocateArray<T>(heap, count_, (T*)inline_);
+        }
+        capacity_ = capacity;
+    }
+
+    union {
+        T* heap_;
+        alignas(T) char inline_[N * sizeof(T)];
+    };
+    unsigned count_ = 0;
+    unsigned capacity_ = N;
+};
+
+template<class T, unsigned N, class T_Allocator>
+struct IsTriviallyRelocatable<InlineArray<T, N, T_Allocator>>
+    : std::integral_constant<bool, IsTriviallyRelocatable<T>::value && IsTriviallyRelocatable<T_Allocator>::value> {
+};
+
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include "Simd.h"
 #include "Set.h"
 #include "Ring.h"
+#include "AllocationTrace.h"
 #include <iostream>
 #include <sstream>
 
@@ -79,7 +80,9 @@ int main(int argc, char* argv[]) {
 
         unsigned frames = 0;
         Timing timing;
+        gg::HeapTrace::Configure(60, false);
         while (!window.isClosing()) {
+            gg::HotRegion frameRegion;
             bool resized = os.GetClientSize(window.hwnd(), width, height);
             x = gg::Clamp(x, 0.f, (float)(width - 8));
             y = gg::Clamp(y, 0.f, (float)(height - 8));
@@ -109,6 +112,12 @@ int main(int argc, char* argv[]) {
         }
 
         //gg::Window::ShowConsole(true);
+
+    #if GG_TRACE_HEAP_ALLOCATIONS
+        if (os.IsDebuggerPresent()) {
+            gg::HeapTrace::Report(gg::Os::PrintDebug);
+        }
+    #endif
     }
 
     std::cout << "Waiting for window to close...";
@@ -0,0 +1,220 @@
+#pragma once
+#ifndef GG_MIRRORED_RING_H
+#define GG_MIRRORED_RING_H
+
+#include "Os.h"
+#include "Span.h"
+#include "MiscUtil.h"
+#include <cstdlib>
+
+namespace gg {
+
+// Ring whose storage is mapped twice, back to back (Os::MapMirrored), so the elements are always contiguous
+// in memory even when they wrap: any run of them can be read or written as one Span, with no copy to split or
+// join the two parts. Storage comes in multiples of the OS allocation granularity (64KB on Windows).
+// An element is reached through either mapping over its lifetime, which only works for types that don't
+// point into themselves, hence trivially relocatable T only.
+template<class T>
+class MirroredRing {
+
+    static_assert(IsTriviallyRelocatable<std::remove_const_t<T>>::value, "Elements change address in place");
+
+public:
+    using Iterator = T*;
+
+    MirroredRing() = default;
+    explicit MirroredRing(size_t initialCapacity)
+        : MirroredRing() {
+        reserve(initialCapacity);
+    }
+    MirroredRing(MirroredRing&& src)
+        : data_(std::exchange(src.data_, nullptr))
+        , first_(std::exchange(src.first_, 0))
+        , count_(std::exchange(src.count_, 0))
+        , capacity_(std::exchange(src.capacity_, 0)) {
+    }
+    MirroredRing(MirroredRing const&) = delete;
+
+    ~MirroredRing() {
+        removeAll();
+        if (data_) {
+            Os::UnmapMirrored(data_, capacity_ * sizeof(T));
+        }
+    }
+
+    MirroredRing& operator=(MirroredRing&& src) {
+        ReconstructInPlace(*this, std::move(src));
+        return *this;
+    }
+
+    T& addLast(T const& source) {
+        return *ConstructInPlace<T>(emplaceLast(1), source);
+    }
+
+    T& addLast(T&& source) {
+        return *ConstructInPlace<T>(emplaceLast(1), std::move(source));
+    }
+
+    template<class... T_Params>
+    T& addLast(T_Params&&... params) {
+        return *ConstructInPlace<T>(emplaceLast(1), std::forward<T_Params>(params)...);
+    }
+
+    // n contiguous new elements, e.g. to read or decode straight into
+    T* addLastN(size_t n) {
+        return ConstructArray<T>(emplaceLast(n), n);
+    }
+
+    void addLastCopiedSpan(Span<T const> span) {
+        CopyConstructArray<T>(emplaceLast(span.count()), span.count(), span.begin());
+    }
+
+    void addLastMovedSpan(Span<T>&& span) {
+        Span<T> temp = std::move(span);
+        MoveArray<T>(emplaceLast(temp.count()), temp.count(), temp.begin());
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity);
+        }
+    }
+
+    void* emplaceLast(size_t n) {
+        reserve(count_ + n);
+        return &data_[first_ + std::exchange(count_, count_ + (unsigned)n)];
+    }
+
+    T removeFirst() {
+        assert(count_ > 0);
+        --count_;
+        T& first = data_[std::exchange(first_, first_ + 1 == capacity_ ? 0 : first_ + 1)];
+        T removed = std::move(first);
+        first.~T();
+        return removed;
+    }
+
+    T removeLast() {
+        assert(count_ > 0);
+        T& last = data_[first_ + --count_];
+        T removed = std::move(last);
+        last.~T();
+        return removed;
+    }
+
+    // Destroys the first n elements, e.g. once they were consumed through slice()
+    void removeFirstN(size_t n) {
+        assert(count_ >= n);
+        DestroyArray(data_ + first_, n);
+        skipFirst((unsigned)n);
+    }
+
+    // Moves the first out.count() elements into out
+    void removeFirstN(Span<T> out) {
+        assert(count_ >= out.count());
+        MoveAssignArray(out.begin(), out.count(), data_ + first_);
+        skipFirst(out.count());
+    }
+
+    void removeLastN(size_t n) {
+        assert(count_ >= n);
+        DestroyArray(data_ + first_ + count_ - n, n);
+        count_ -= (unsigned)n;
+    }
+
+    void removeAll() {
+        removeLastN(count_);
+    }
+
+    Iterator begin() const {
+        return data_ + first_;
+    }
+
+    Iterator end() const {
+        return data_ + first_ + count_;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    unsigned capacity() const {
+        return capacity_;
+    }
+
+    T& operator[](size_t i) const {
+        assert(i < count_);
+        return data_[first_ + i];
+    }
+
+    // Elements [start, end), contiguous whether or not they wrap
+    Span<T> slice(size_t start, size_t end) const {
+        assert(start <= end && end <= count_);
+        return {data_ + first_ + start, end - start};
+    }
+
+    operator Span<T>() const {
+        return {data_ + first_, count_};
+    }
+
+    // All the elements, like Ring::frontSpan(); backSpan() is always empty
+    Span<T> frontSpan() const {
+        return *this;
+    }
+
+    Span<T> backSpan() const {
+        return {data_, 0};
+    }
+
+    std::remove_const_t<T>* linearizeCopy(std::remove_const_t<T>* dest) const {
+        if (count_) {
+            CopyConstructArray<T>(dest, count_, data_ + first_);
+        }
+        return dest;
+    }
+
+private:
+    // Drops the first n elements, which were already destroyed or moved out
+    void skipFirst(unsigned n) {
+        first_ += n;
+        first_ -= first_ >= capacity_ ? capacity_ : 0;
+        count_ -= n;
+    }
+
+    // Whole granules that hold a whole number of elements, so element capacity_ is element 0 again
+    static size_t GetCapacityFor(size_t requestedCapacity) {
+        size_t const granularity = Os::GetAllocationGranularity();
+        size_t a = granularity, b = sizeof(T);
+        while (b) {
+            a = std::exchange(b, a % b);
+        }
+        size_t const unit = granularity / a;    // (a: greatest common divisor of the two)
+        return (requestedCapacity + unit - 1) / unit * unit;
+    }
+
+    GG_NO_INLINE void grow(size_t requestedCapacity) {
+        assert((unsigned)requestedCapacity > capacity_);
+        size_t const capacity = GetCapacityFor(std::max(requestedCapacity, (size_t)capacity_ * 2));
+        T* const data = (T*)Os::MapMirrored(capacity * sizeof(T));
+        if (!data) {
+            assert(!"Out of address space");
+            std::abort();
+        }
+        if (data_) {
+            RelocateArray<T>(data, count_, data_ + first_);
+            Os::UnmapMirrored(data_, capacity_ * sizeof(T));
+        }
+        data_ = data;
+        first_ = 0;
+        capacity_ = (unsigned)capacity;
+    }
+
+    T* data_ = nullptr;
+    unsigned first_ = 0;
+    unsigned count_ = 0;
+    unsigned capacity_ = 0;
+};
+
+}
+
+#endif
@@ -27,9 +27,6 @@
 
 #endif
 
-// TODO calling alloca inside argument list is sketchy af; msvc does the right thing, not sure about others...
-#define GG_STACK_ARRAY(type, count, ...) gg::ConstructArray<type>(GG_ALLOCA((count)*sizeof(type)), count, __VA_ARGS__)
-
 namespace gg {
 
 template<class T, unsigned N>
@@ -39,12 +36,16 @@ constexpr unsigned CountOf(T (&)[N]) {
 
 unsigned CountLeadingZeroBits(uint32_t bits);
 unsigned CountLeadingZeroBits(uint64_t bits);
+unsigned CountTrailingZeroBits(uint32_t bits);
+unsigned CountTrailingZeroBits(uint64_t bits);
 unsigned CountNonzeroBits(uint32_t bits);
 unsigned CountNonzeroBits(uint64_t bits);
 uint32_t RotateBitsLeft(uint32_t bits, unsigned shift);
 uint64_t RotateBitsLeft(uint64_t bits, unsigned shift);
 uint32_t RotateBitsRight(uint32_t bits, unsigned shift);
 uint64_t RotateBitsRight(uint64_t bits, unsigned shift);
+void CpuRelax();    // (in spin-wait loops)
+void Prefetch(void const* p);
 
 inline unsigned FloorLog2(uint32_t x) {
     return 31 - CountLeadingZeroBits(x);
@@ -90,11 +91,19 @@ inline uint64_t NextPow2(uint64_t x) {
     return result + 1;
 }
 
+// Objects that can be moved with memcpy, after which the source is simply forgotten (not destroyed).
+// Trivially copyable types qualify automatically; specialize to opt other types in.
+template<class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {
+};
+
 template<class T, class... T_Params> T* ConstructInPlace(void* mem, T_Params&&... params);
 template<class T, class... T_Params> T* ReconstructInPlace(T& obj, T_Params&&... params);
 template<class T, class... T_Params> T* ConstructArray(void* mem, size_t count, T_Params&&... params);
 template<class T> T* CopyConstructArray(void* dest, size_t count, T const* source);
 template<class T> T* MoveArray(void* dest, size_t count, T* source); // move elements & destruct source
+template<class T> T* RelocateArray(void* dest, size_t count, T* source); // move elements; source memory is left dead
+template<class T> T* MoveAssignArray(T* dest, size_t count, T* source); // move-assign into constructed elements & destruct source
 template<class T> void DestroyArray(T* mem, size_t count);
 
 namespace Internal {
@@ -159,6 +168,49 @@ GG_FORCE_INLINE T* CopyConstructArrayImpl(void* dest, size_t count, T const* sou
     return result;
 }
 
+template<class T>
+GG_FORCE_INLINE T* MoveArrayImpl(void* dest, size_t count, T* source, std::true_type) {
+    return (T*)memcpy(dest, source, count * sizeof(T));
+}
+
+template<class T>
+GG_FORCE_INLINE T* MoveArrayImpl(void* dest, size_t count, T* source, std::false_type) {
+    auto* const result = (std::remove_const_t<T>*)dest;
+    for (size_t i = 0; i < count; i++) {
+        ConstructInPlace<T>(result + i, std::move(source[i]));
+    }
+    return result;
+}
+
+template<class T>
+GG_FORCE_INLINE T* RelocateArrayImpl(void* dest, size_t count, T* source, std::true_type) {
+    return (T*)memcpy(dest, source, count * sizeof(T));
+}
+
+template<class T>
+GG_FORCE_INLINE T* RelocateArrayImpl(void* dest, size_t count, T* source, std::false_type) {
+    auto* const result = (std::remove_const_t<T>*)dest;
+    for (size_t i = 0; i < count; i++) {
+        ConstructInPlace<T>(result + i, std::move(source[i]));
+        source[i].~T();
+    }
+    return result;
+}
+
+template<class T>
+GG_FORCE_INLINE T* MoveAssignArrayImpl(T* dest, size_t count, T* source, std::true_type) {
+    return (T*)memcpy(dest, source, count * sizeof(T));
+}
+
+template<class T>
+GG_FORCE_INLINE T* MoveAssignArrayImpl(T* dest, size_t count, T* source, std::false_type) {
+    for (size_t i = 0; i < count; i++) {
+        dest[i] = std::move(source[i]);
+        source[i].~T();
+    }
+    return dest;
+}
+
 }
 
 template<class T, class... T_Params>
@@ -180,11 +232,15 @@ T* CopyConstructArray(void* dest, size_t count, T const* source) {
 }
 template<class T>
 T* MoveArray(void* dest, size_t count, T* source) {
-    auto* const result = (std::remove_const_t<T>*)dest;
-    for (size_t i = 0; i < count; i++) {
-        ConstructInPlace<T>(result + i, std::move(source[i]));
-    }
-    return result;
+    return Internal::MoveArrayImpl<T>(dest, count, source, std::is_trivially_copyable<T>());
+}
+template<class T>
+T* RelocateArray(void* dest, size_t count, T* source) {
+    return Internal::RelocateArrayImpl<T>(dest, count, source, IsTriviallyRelocatable<std::remove_const_t<T>>());
+}
+template<class T>
+T* MoveAssignArray(T* dest, size_t count, T* source) {
+    return Internal::MoveAssignArrayImpl<T>(dest, count, source, std::is_trivially_copyable<T>());
 }
 template<class T>
 void DestroyArray(T* mem, size_t count) {
@@ -3,6 +3,8 @@
 #define GG_ALIGN_16 __declspec(align(16))
 #define GG_ALLOCA(size) _alloca(size)
 
+#include <intrin.h>
+
 namespace gg {
 
 inline unsigned CountLeadingZeroBits(uint32_t bits) {
@@ -17,6 +19,16 @@ inline unsigned CountLeadingZeroBits(uint64_t bits) {
     return 63 - (_BitScanReverse64(&count, bits) == 0 ? -1 : count);
 }
 
+inline unsigned CountTrailingZeroBits(uint32_t bits) {
+    unsigned long count;
+    return _BitScanForward(&count, bits) == 0 ? 32 : count;
+}
+
+inline unsigned CountTrailingZeroBits(uint64_t bits) {
+    unsigned long count;
+    return _BitScanForward64(&count, bits) == 0 ? 64 : count;
+}
+
 inline unsigned CountNonzeroBits(uint32_t bits) {
     return __popcnt(bits);
 }
@@ -41,4 +53,20 @@ inline uint64_t RotateBitsRight(uint64_t bits, unsigned shift) {
     return _rotr64(bits, shift);
 }
 
+inline void Prefetch(void const* p) {
+#if defined(_M_ARM64)
+    __prefetch(p);
+#else
+    _mm_prefetch((char const*)p, _MM_HINT_T0);
+#endif
+}
+
+inline void CpuRelax() {
+#if defined(_M_ARM64)
+    __yield();
+#else
+    _mm_pause();
+#endif
+}
+
 }
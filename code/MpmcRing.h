@@ -0,0 +1,143 @@
+#pragma once
+#ifndef GG_MPMC_RING_H
+#define GG_MPMC_RING_H
+
+#include "Allocator.h"
+#include "Span.h"
+#include "MiscUtil.h"
+#include <atomic>
+
+namespace gg {
+
+// Fixed-capacity Ring for any number of producer and consumer threads, without locks (Vyukov's bounded queue).
+// Each slot has a sequence number that says whose turn it is: position p's slot holds p when free for that
+// producer, and p + 1 once filled for that consumer. A thread claims positions by advancing the shared
+// last/first with a compare-exchange, and then fills or drains its slots without further contention.
+// The positions themselves are relaxed: a slot's contents are ordered only by the release store of its
+// sequence after filling/draining it, paired with the acquire load a claim makes before touching it.
+template<class T, class T_Allocator = Mallocator>
+class MpmcRing : private T_Allocator {
+
+public:
+    explicit MpmcRing(size_t capacity, T_Allocator const& allocator = T_Allocator())
+        : T_Allocator(allocator)
+        , mask_(NextPow2(std::max((unsigned)capacity, 2u)) - 1) {
+        data_ = (T*)allocate((mask_ + 1) * sizeof(T), alignof(T));
+        sequences_ = (std::atomic<unsigned>*)allocate((mask_ + 1) * sizeof(std::atomic<unsigned>), alignof(std::atomic<unsigned>));
+        for (unsigned i = 0; i <= mask_; i++) {
+            ConstructInPlace<std::atomic<unsigned>>(sequences_ + i, i);
+        }
+    }
+    MpmcRing(MpmcRing const&) = delete;
+
+    ~MpmcRing() {
+        unsigned const last = last_.position.load(std::memory_order_relaxed);
+        for (unsigned i = first_.position.load(std::memory_order_relaxed); i != last; i++) {
+            data_[i & mask_].~T();
+        }
+        deallocate(sequences_);
+        deallocate(data_);
+    }
+
+    unsigned capacity() const {
+        return mask_ + 1;
+    }
+
+    // (A snapshot, and may include items still being written or read)
+    unsigned count() const {
+        return last_.position.load(std::memory_order_relaxed) - first_.position.load(std::memory_order_relaxed);
+    }
+
+    // False if full
+    template<class... T_Params>
+    bool tryPush(T_Params&&... params) {
+        unsigned position;
+        if (!claim(last_.position, 1, 0, &position)) {
+            return false;
+        }
+        ConstructInPlace<T>(data_ + (position & mask_), std::forward<T_Params>(params)...);
+        sequences_[position & mask_].store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // False if empty
+    bool tryPop(T& out) {
+        unsigned position;
+        if (!claim(first_.position, 1, 1, &position)) {
+            return false;
+        }
+        T& item = data_[position & mask_];
+        out = std::move(item);
+        item.~T();
+        sequences_[position & mask_].store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Copies in as many of the first items as there are free slots in a row, with one claim. Returns how many.
+    unsigned tryPushSpan(Span<T const> items) {
+        unsigned position;
+        unsigned const count = claim(last_.position, items.count(), 0, &position);
+        for (unsigned i = 0; i < count; i++) {
+            ConstructInPlace<T>(data_ + ((position + i) & mask_), items[i]);
+            sequences_[(position + i) & mask_].store(position + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Moves out as many items as are ready in a row, up to out.count(), with one claim. Returns how many.
+    unsigned tryPopSpan(Span<T> out) {
+        unsigned position;
+        unsigned const count = claim(first_.position, out.count(), 1, &position);
+        for (unsigned i = 0; i < count; i++) {
+            T& item = data_[(position + i) & mask_];
+            out[i] = std::move(item);
+            item.~T();
+            sequences_[(position + i) & mask_].store(position + i + mask_ + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+private:
+    // Claims up to n positions in a row from shared, whose slots must have sequence (position + lag).
+    // Returns how many, 0 if the first slot isn't ready (ring full for producers, empty for consumers).
+    unsigned claim(std::atomic<unsigned>& shared, unsigned n, unsigned lag, unsigned* claimed) {
+        if (!n) {
+            return 0;
+        }
+        unsigned position = shared.load(std::memory_order_relaxed);
+        for (;;) {
+            unsigned ready = 0;
+            while (ready < n && ready <= mask_ &&
+                sequences_[(position + ready) & mask_].load(std::memory_order_acquire) == position + ready + lag) {
+                ready++;
+            }
+            if (ready) {
+                if (shared.compare_exchange_weak(position, position + ready, std::memory_order_relaxed)) {
+                    *claimed = position;
+                    return ready;
+                }
+            } else {
+                // Behind means the slot is still in use from the previous lap; otherwise another thread got here first
+                int const behind = (int)(sequences_[position & mask_].load(std::memory_order_acquire) - (position + lag));
+                if (behind < 0) {
+                    return 0;
+                }
+                position = shared.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    struct alignas(64) Position {
+        std::atomic<unsigned> position = {0};
+    };
+
+    T* data_ = nullptr;
+    std::atomic<unsigned>* sequences_ = nullptr;
+    unsigned const mask_;
+    Position last_;     // (next to push)
+    Position first_;    // (next to pop)
+};
+
+}
+
+#endif
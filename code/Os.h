@@ -3,6 +3,7 @@
 #define GG_OS_H
 
 #include <cstdint>
+#include <cstddef>
 
 namespace gg {
 
@@ -32,6 +33,19 @@ public:
     static void GetMaxWindowSize(unsigned& widthOut, unsigned& heightOut);
     static bool GetClientSize(void const* windowHandle, unsigned& widthOut, unsigned& heightOut);
 
+    static size_t GetPageSize();
+    static void* ReserveAddressSpace(size_t bytes);     // inaccessible until committed
+    static bool CommitPages(void* first, size_t bytes);
+    static void ReleaseAddressSpace(void* first, size_t bytes);
+
+    // Maps the same bytes twice, back to back, so first[i] and first[bytes + i] are the same memory.
+    // bytes must be a multiple of GetAllocationGranularity(). Returns nullptr on failure.
+    static size_t GetAllocationGranularity();
+    static void* MapMirrored(size_t bytes);
+    static void UnmapMirrored(void* first, size_t bytes);
+
+    static unsigned CaptureCallStack(void** framesOut, unsigned maxFrames, unsigned skipFrames);
+
     static bool IsDebuggerPresent();
     static void PrintDebug(char const* text);
 
@@ -1,5 +1,6 @@
 #include "Os.h"
 #include <algorithm>
+#include <cassert>
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -36,6 +37,73 @@ bool Os::GetClientSize(void const* windowHandle, unsigned& widthOut, unsigned& h
     return (widthOld != widthOut) | (heightOld != heightOut);
 }
 
+size_t Os::GetPageSize() {
+    static size_t const pageSize = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (size_t)info.dwPageSize;
+    }();
+    return pageSize;
+}
+
+void* Os::ReserveAddressSpace(size_t bytes) {
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool Os::CommitPages(void* first, size_t bytes) {
+    return VirtualAlloc(first, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void Os::ReleaseAddressSpace(void* first, size_t bytes) {
+    VirtualFree(first, 0, MEM_RELEASE);
+}
+
+size_t Os::GetAllocationGranularity() {
+    static size_t const granularity = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (size_t)info.dwAllocationGranularity;
+    }();
+    return granularity;
+}
+
+void* Os::MapMirrored(size_t bytes) {
+    assert(bytes % GetAllocationGranularity() == 0);
+    HANDLE const mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        (DWORD)((uint64_t)bytes >> 32), (DWORD)bytes, nullptr);
+    if (!mapping) {
+        return nullptr;
+    }
+    // Find a free range for both views, then map them into it. Another thread may take the range in between,
+    // so try again if that happens.
+    void* result = nullptr;
+    for (unsigned attempt = 0; attempt < 16 && !result; attempt++) {
+        char* const range = (char*)VirtualAlloc(nullptr, 2 * bytes, MEM_RESERVE, PAGE_NOACCESS);
+        if (!range) {
+            break;
+        }
+        VirtualFree(range, 0, MEM_RELEASE);
+        void* const first = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes, range);
+        void* const second = first ? MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes, range + bytes) : nullptr;
+        if (second) {
+            result = first;
+        } else if (first) {
+            UnmapViewOfFile(first);
+        }
+    }
+    CloseHandle(mapping);   // (the views keep it alive)
+    return result;
+}
+
+void Os::UnmapMirrored(void* first, size_t bytes) {
+    UnmapViewOfFile((char*)first + bytes);
+    UnmapViewOfFile(first);
+}
+
+unsigned Os::CaptureCallStack(void** framesOut, unsigned maxFrames, unsigned skipFrames) {
+    return CaptureStackBackTrace(skipFrames + 1, maxFrames, framesOut, nullptr);
+}
+
 bool Os::IsDebuggerPresent() {
     return ::IsDebuggerPresent() == TRUE;
 }
@@ -0,0 +1,289 @@
+#pragma once
+#ifndef GG_PERFECT_TABLE_H
+#define GG_PERFECT_TABLE_H
+
+#include "Array.h"
+#include "Hash.h"
+
+namespace gg {
+
+// Keys that are equal exactly when their bytes are, and that mean the same in another process: no pointers,
+// no padding, no floats (-0 == +0, NaN != NaN). Integers and enums qualify; specialize to opt other types in.
+template<class T>
+struct IsPerfectTableKey : std::integral_constant<bool, std::is_integral<T>::value || std::is_enum<T>::value> {
+};
+
+// Immutable table over a fixed key set, built once with a minimal perfect hash (CHD/PTHash style): keys are
+// split into buckets of ~4, and each bucket gets a pilot value that sends its keys to free slots. A lookup is
+// one slot plus one key compare, and there are exactly as many slots as keys.
+// The table lives in a single flat buffer, so it can be saved as is (getBuffer()) and used straight from a
+// loaded or mapped file (FromBuffer()). Keys and values must be trivially copyable, and for that to work
+// across processes, values must be free of pointers.
+// Keys are hashed and compared as bytes (two seeded BufferHash32s, so 64 bits per key; a 32-bit key traits
+// Hash collides too often at this scale), so they must be IsPerfectTableKey: for strings, key on a
+// fixed-size name or a 64-bit name hash rather than on a pointer.
+template<class T_Key, class T_Value, class T_Allocator = Mallocator>
+class PerfectTable : private T_Allocator {
+
+    static_assert(std::is_trivially_copyable<T_Key>::value && std::is_trivially_copyable<T_Value>::value,
+        "PerfectTable is stored as a flat buffer");
+    static_assert(IsPerfectTableKey<T_Key>::value,
+        "PerfectTable keys are hashed and compared as bytes: specialize IsPerfectTableKey for pointer-free types without padding");
+
+public:
+    enum : uint32_t {
+        cMagic = 0x48505047,    // 'GPPH'
+        cKeysPerBucket = 4,
+        cMinMaxPilot = 1 << 16, // (tries per bucket before starting over with another seed, at least this and 16 * count)
+        cMaxSeeds = 32,         // (each fails with tiny probability unless keys repeat)
+    };
+
+    PerfectTable() = default;
+    PerfectTable(PerfectTable&& src)
+        : T_Allocator(std::move(src))
+        , header_(std::exchange(src.header_, nullptr))
+        , owned_(std::exchange(src.owned_, false)) {
+    }
+    PerfectTable(PerfectTable const&) = delete;
+
+    // Keys must be unique; if they aren't (or no seed works), the table is left empty
+    PerfectTable(Span<T_Key const> keys, Span<T_Value const> values) {
+        assert(keys.count() == values.count());
+        build(keys, values);
+    }
+
+    ~PerfectTable() {
+        if (owned_) {
+            deallocate(header_);
+        }
+    }
+
+    PerfectTable& operator=(PerfectTable&& src) {
+        ReconstructInPlace(*this, std::move(src));
+        return *this;
+    }
+
+    // Uses the buffer in place (it must outlive the table). Returns an empty table if it isn't one of ours.
+    static PerfectTable FromBuffer(void const* buffer, size_t bytes) {
+        PerfectTable table;
+        if (!bytes) {
+            return table;   // (an empty table's buffer)
+        }
+        Header const* const header = (Header const*)buffer;
+        bool const valid = bytes >= sizeof(Header) && header->magic == cMagic && header->entrySize == sizeof(Entry)
+            && bytes >= GetBufferSize(header->count, header->bucketCount);
+        assert(valid);
+        if (valid) {
+            table.header_ = (Header*)header;
+        }
+        return table;
+    }
+
+    Span<uint8_t const> getBuffer() const {
+        return {(uint8_t const*)header_, header_ ? GetBufferSize(header_->count, header_->bucketCount) : 0};
+    }
+
+    unsigned count() const {
+        return header_ ? header_->count : 0;
+    }
+
+    T_Value const* find(T_Key const& key) const {
+        if (!count()) {
+            return nullptr;
+        }
+        uint32_t bucketHash, slotHash;
+        GetKeyHashes(key, header_->seed, bucketHash, slotHash);
+        uint32_t const pilot = getPilots()[ScaleHash(bucketHash, header_->bucketCount)];
+        Entry const& entry = getEntries()[GetSlot(slotHash, pilot, header_->count)];
+        return KeysEqual(entry.key, key) ? &entry.value : nullptr;
+    }
+
+    // Entries in slot order
+    template<class T_Visit>
+    void forEach(T_Visit&& visit) const {
+        for (unsigned i = 0; i < count(); i++) {
+            visit(getEntries()[i].key, getEntries()[i].value);
+        }
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t entrySize;     // (catches reading a buffer built for other types)
+        uint32_t count;
+        uint32_t bucketCount;
+        uint32_t seed;
+    };
+
+    struct Entry {
+        T_Key key;
+        T_Value value;
+    };
+
+    // Header, then one pilot per bucket, then the entries
+    static size_t GetEntriesOffset(uint32_t bucketCount) {
+        size_t const offset = sizeof(Header) + bucketCount * sizeof(uint32_t);
+        return (offset + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+    }
+
+    static size_t GetBufferSize(uint32_t count, uint32_t bucketCount) {
+        return GetEntriesOffset(bucketCount) + count * sizeof(Entry);
+    }
+
+    uint32_t const* getPilots() const {
+        return (uint32_t const*)(header_ + 1);
+    }
+
+    Entry const* getEntries() const {
+        return (Entry const*)((char const*)header_ + GetEntriesOffset(header_->bucketCount));
+    }
+
+    static bool KeysEqual(T_Key const& a, T_Key const& b) {
+        return memcmp(&a, &b, sizeof(T_Key)) == 0;
+    }
+
+    // Two independent 32-bit hashes, so distinct keys only become inseparable if both collide
+    static void GetKeyHashes(T_Key const& key, uint32_t seed, uint32_t& bucketHash, uint32_t& slotHash) {
+        bucketHash = BufferHash32(&key, sizeof(T_Key), seed);
+        slotHash = BufferHash32(&key, sizeof(T_Key), ~seed);
+    }
+
+    // Maps a 32-bit hash onto [0, range) without a division
+    static uint32_t ScaleHash(uint32_t hash, uint32_t range) {
+        return (uint32_t)(((uint64_t)hash * range) >> 32);
+    }
+
+    static uint32_t GetSlot(uint32_t slotHash, uint32_t pilot, uint32_t count) {
+        return ScaleHash((slotHash ^ Internal::HashFinalMix(pilot + 1)) * 0x9e3779b1, count);
+    }
+
+    GG_NO_INLINE void build(Span<T_Key const> keys, Span<T_Value const> values) {
+        uint32_t const count = keys.count();
+        if (!count) {
+            return;
+        }
+        uint32_t const bucketCount = (count + cKeysPerBucket - 1) / cKeysPerBucket;
+        Array<uint32_t> pilots;
+        Array<uint32_t> slots;      // (key index per slot)
+        uint32_t seed = 0xdecafbad;
+        bool built = false;
+        bool duplicates = false;
+        for (unsigned attempt = 0; attempt < cMaxSeeds && !duplicates; attempt++) {
+            built = tryBuild(keys, seed, bucketCount, pilots, slots, duplicates);
+            if (built) {
+                break;
+            }
+            seed = Internal::HashFinalMix(seed) + 1;
+        }
+        assert(!duplicates);    // Keys must be unique
+        assert(built || duplicates);
+        if (!built) {
+            return;
+        }
+
+        size_t const bytes = GetBufferSize(count, bucketCount);
+        header_ = (Header*)allocate(bytes, std::max(alignof(Header), alignof(Entry)));
+        owned_ = true;
+        memset(header_, 0, bytes);  // (deterministic padding, for saving)
+        *header_ = {cMagic, sizeof(Entry), count, bucketCount, seed};
+        memcpy(header_ + 1, pilots.begin(), bucketCount * sizeof(uint32_t));
+        Entry* const entries = (Entry*)getEntries();
+        for (uint32_t slot = 0; slot < count; slot++) {
+            entries[slot].key = keys[slots[slot]];
+            entries[slot].value = values[slots[slot]];
+        }
+    }
+
+    // Places buckets largest first, each with the first pilot that puts all its keys in free slots
+    // A bucket that no pilot can place may hold a repeated key, which no seed would fix: that sets duplicates.
+    static bool tryBuild(Span<T_Key const> keys, uint32_t seed, uint32_t bucketCount,
+        Array<uint32_t>& pilots, Array<uint32_t>& slots, bool& duplicates) {
+        uint32_t const count = keys.count();
+        uint32_t const cUnused = ~0u;
+        // The last buckets placed find few free slots, so a key alone in its bucket needs ~count tries at worst
+        uint32_t const maxPilot = (uint32_t)std::min(std::max((uint64_t)cMinMaxPilot, (uint64_t)16 * count), (uint64_t)~0u);
+
+        // Counting sort of key indices by bucket
+        Array<uint32_t> slotHashes;
+        Array<uint32_t> keyBuckets;
+        Array<uint32_t> bucketStarts;
+        slotHashes.setCount(count);
+        keyBuckets.setCount(count);
+        bucketStarts.setCount(bucketCount + 1);
+        memset(bucketStarts.begin(), 0, bucketStarts.count() * sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t bucketHash;
+            GetKeyHashes(keys[i], seed, bucketHash, slotHashes[i]);
+            keyBuckets[i] = ScaleHash(bucketHash, bucketCount);
+            bucketStarts[keyBuckets[i] + 1]++;
+        }
+        uint32_t maxBucketSize = 0;
+        for (uint32_t b = 0; b < bucketCount; b++) {
+            maxBucketSize = std::max(maxBucketSize, bucketStarts[b + 1]);
+            bucketStarts[b + 1] += bucketStarts[b];
+        }
+        Array<uint32_t> bucketKeys;
+        bucketKeys.setCount(count);
+        {
+            Array<uint32_t> fill;
+            fill.addLastCopiedSpan(bucketStarts.slice(0, bucketCount));
+            for (uint32_t i = 0; i < count; i++) {
+                bucketKeys[fill[keyBuckets[i]]++] = i;
+            }
+        }
+
+        pilots.setCount(bucketCount);
+        slots.setCount(count);
+        memset(slots.begin(), 0xff, count * sizeof(uint32_t));
+        Array<uint32_t> candidate;
+        candidate.setCount(maxBucketSize);
+
+        for (uint32_t size = maxBucketSize; size > 0; size--) {
+            for (uint32_t b = 0; b < bucketCount; b++) {
+                uint32_t const first = bucketStarts[b];
+                if (bucketStarts[b + 1] - first != size) {
+                    continue;
+                }
+                uint32_t pilot = 0;
+                for (; pilot < maxPilot; pilot++) {
+                    uint32_t placed = 0;
+                    for (; placed < size; placed++) {
+                        uint32_t const slot = GetSlot(slotHashes[bucketKeys[first + placed]], pilot, count);
+                        if (slots[slot] != cUnused || std::find(candidate.begin(), candidate.begin() + placed, slot) != candidate.begin() + placed) {
+                            break;
+                        }
+                        candidate[placed] = slot;
+                    }
+                    if (placed == size) {
+                        break;
+                    }
+                }
+                if (pilot == maxPilot) {
+                    for (uint32_t i = first; i < first + size; i++) {
+                        for (uint32_t j = i + 1; j < first + size; j++) {
+                            duplicates |= KeysEqual(keys[bucketKeys[i]], keys[bucketKeys[j]]);
+                        }
+                    }
+                    return false;
+                }
+                pilots[b] = pilot;
+                for (uint32_t i = 0; i < size; i++) {
+                    slots[candidate[i]] = bucketKeys[first + i];
+                }
+            }
+        }
+        for (uint32_t b = 0; b < bucketCount; b++) {
+            if (bucketStarts[b + 1] == bucketStarts[b]) {
+                pilots[b] = 0;
+            }
+        }
+        return true;
+    }
+
+    Header* header_ = nullptr;
+    bool owned_ = false;
+};
+
+}
+
+#endif
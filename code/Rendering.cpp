@@ -435,8 +435,8 @@ struct Rendering::Hub::Platform {
     gg::vk::DestructionFifo<VkSurfaceKHR> graphicsSurfaceDestructionFifo;
     gg::vk::DestructionFifo<VkRenderPass> graphicsRenderPassDestructionFifo;
     gg::vk::DestructionFifo<VkPipeline> graphicsPipelineDestructionFifo;
-    Array<VkSemaphore> graphicsWaitSemaphores;
-    Array<VkPipelineStageFlags> graphicsWaitDstStageMasks;
+    InlineArray<VkSemaphore, 4> graphicsWaitSemaphores;
+    InlineArray<VkPipelineStageFlags, 4> graphicsWaitDstStageMasks;
 
     gg::vk::CommandBufferDispenser transferCommandBufferDispenser;
     gg::vk::QueueTracker transferQueueTracker;
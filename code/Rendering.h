@@ -3,6 +3,7 @@
 #define GG_RENDERING_H
 
 #include "Table.h"
+#include "InlineArray.h"
 #include "ResourcePool.h"
 #include "RenderTypes.h"
 
@@ -65,10 +66,14 @@ private:
     PipelineId pipelineId_;
     Array<SpritePrim> spritePrims_;
     Array<ImagePrim> imagePrims_;
-    Array<Rendering*> antecedents_;
+    InlineArray<Rendering*, 4> antecedents_;
 };
 
 
+template<>
+struct IsTriviallyRelocatable<Rendering> : std::true_type {   // (members are all relocatable)
+};
+
 class Rendering::Hub {
 
 public:
@@ -13,7 +13,7 @@ struct ResourceIdTraitsDefault {
     }
 };
 
-template<class T_Id, class T, class T_ResourceIdTraits = ResourceIdTraitsDefault<T_Id>>
+template<class T_Id, class T, class T_ResourceIdTraits = ResourceIdTraitsDefault<T_Id>, class T_Allocator = Mallocator>
 class ResourcePool {
 
 public:
@@ -44,8 +44,8 @@ public:
     }
 
 private:
-    gg::Array<T> items_;
-    gg::Array<unsigned> freeList_;
+    gg::Array<T, T_Allocator> items_;
+    gg::Array<unsigned, T_Allocator> freeList_;
 };
 
 }
@@ -19,6 +19,9 @@ public:
         : Ring() {
         reserve(initialCapacity);
     }
+    explicit Ring(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
     Ring(Ring&& src)
         : T_Allocator(std::move(src))
         , data_(std::exchange(src.data_, nullptr))
@@ -45,6 +48,26 @@ public:
         return *ConstructInPlace<T>(emplaceLast(), std::forward<T_Params>(params)...);
     }
 
+    // Copies the span in with at most two CopyConstructArray runs (memcpy for trivially copyable T)
+    void addLastCopiedSpan(Span<T const> span) {
+        if (span.count()) {
+            unsigned const frontCount = prepareAddLastSpan(span.count());
+            CopyConstructArray<T>(&data_[(first_ + count_) & mask_], frontCount, span.begin());
+            CopyConstructArray<T>(data_, span.count() - frontCount, span.begin() + frontCount);
+            count_ += span.count();
+        }
+    }
+
+    void addLastMovedSpan(Span<T>&& span) {
+        Span<T> temp = std::move(span);
+        if (temp.count()) {
+            unsigned const frontCount = prepareAddLastSpan(temp.count());
+            MoveArray<T>(&data_[(first_ + count_) & mask_], frontCount, temp.begin());
+            MoveArray<T>(data_, temp.count() - frontCount, temp.begin() + frontCount);
+            count_ += temp.count();
+        }
+    }
+
     void reserve(size_t capacity) {
         if (capacity > mask_ + 1) {
             grow(capacity);
@@ -67,6 +90,19 @@ public:
         return std::move(data_[(first_ + --count_) & mask_]);
     }
 
+    // Moves the first out.count() elements into out, in at most two runs
+    void removeFirstN(Span<T> out) {
+        assert(count_ >= out.count());
+        if (!out.count()) {
+            return;
+        }
+        unsigned const frontCount = std::min(out.count(), mask_ + 1 - first_);
+        MoveAssignArray(out.begin(), frontCount, &data_[first_]);
+        MoveAssignArray(out.begin() + frontCount, out.count() - frontCount, data_);
+        first_ = (first_ + out.count()) & mask_;
+        count_ -= out.count();
+    }
+
     void removeLastN(size_t n) {
         assert(count_ >= n);
         unsigned const end = first_ + count_;
@@ -105,22 +141,35 @@ public:
         return {data_, std::max(first_ + count_, mask_ + 1) - mask_ - 1};
     }
 
+    // (At most two memcpys for trivially copyable T)
     std::remove_const_t<T>* linearizeCopy(std::remove_const_t<T>* dest) const {
-        for (unsigned i = 0; i < count_; i++) {
-            ConstructInPlace<T>(dest + i, data_[(first_ + i) & mask_]);
+        if (count_) {
+            Span<T> const front = frontSpan();
+            Span<T> const back = backSpan();
+            CopyConstructArray<T>(dest, front.count(), front.begin());
+            CopyConstructArray<T>(dest + front.count(), back.count(), back.begin());
         }
         return dest;
     }
 
 private:
+    // Makes room for count more at the end, returning how many fit before the wrap
+    unsigned prepareAddLastSpan(unsigned count) {
+        reserve(count_ + count);
+        return std::min(count, mask_ + 1 - ((first_ + count_) & mask_));
+    }
+
     GG_NO_INLINE void grow(size_t requestedCapacity) {
         assert((unsigned)requestedCapacity > mask_ + 1);
         unsigned capacity = (requestedCapacity > 2*mask_ + 2) ? NextPow2((unsigned)requestedCapacity) : 2*mask_ + 2;
-        auto* data = (std::remove_const_t<T>*)allocate(capacity * sizeof(T), alignof(T));
-        MoveArray<T>(data, std::min(mask_ + 1 - first_, count_), &data_[first_]);
-        if (first_ + count_ > mask_ + 1) {
-            MoveArray<T>(data + mask_ + 1 - first_, first_ + count_ - mask_ - 1, data_);
+        if (first_ + count_ <= mask_ + 1) {
+            data_ = ReallocateArray<T, T_Allocator>(*this, data_, first_, count_, capacity);   // (contents don't wrap, so they keep their slots)
+            mask_ = capacity - 1;
+            return;
         }
+        auto* data = (std::remove_const_t<T>*)allocate(capacity * sizeof(T), alignof(T));
+        RelocateArray<T>(data, mask_ + 1 - first_, &data_[first_]);
+        RelocateArray<T>(data + mask_ + 1 - first_, first_ + count_ - mask_ - 1, data_);
         deallocate(std::exchange(data_, data));
         first_ = 0;
         mask_ = capacity - 1;
@@ -132,6 +181,10 @@ private:
     unsigned mask_ = -1;
 };
 
+template<class T, class T_Allocator>
+struct IsTriviallyRelocatable<Ring<T, T_Allocator>> : IsTriviallyRelocatable<T_Allocator> {
+};
+
 template<class T, class T_Allocator>
 class Ring<T, T_Allocator>::Iterator {
 public:
@@ -4,6 +4,8 @@
 
 #include "Allocator.h"
 #include "Hash.h"
+#include "HashProbing.h"
+#include "Span.h"
 
 namespace gg {
 
@@ -24,8 +26,11 @@ struct HashElementTraitsDefault<std::pair<T_Key, T_Value>> {
     }
 };
 
-template<class T_Elem, class T_ElemTraits = HashElementTraitsDefault<T_Elem>, class T_Allocator = Mallocator>
-class Set : private T_Allocator {
+template<class T_Elem, class T_ElemTraits = HashElementTraitsDefault<T_Elem>, class T_Allocator = Mallocator,
+    class T_Probing = LinearProbing>
+class Set : private Internal::LinearProbingBase<T_Allocator, T_Probing::cCacheHashes != 0> {
+
+    using Base = Internal::LinearProbingBase<T_Allocator, T_Probing::cCacheHashes != 0>;
 
 public:
     Set() = default;
@@ -36,8 +41,11 @@ public:
         : Set() {
         reserve(initialCapacity);
     }
+    explicit Set(T_Allocator const& allocator)
+        : Base(allocator) {
+    }
     Set(Set&& src)
-        : T_Allocator(std::move(src))
+        : Base(std::move(src))
         , elements_(std::exchange(src.elements_, nullptr))
         , count_(std::exchange(src.count_, 0))
         , mask_(std::exchange(src.mask_, 0)) {
@@ -50,10 +58,16 @@ public:
         assert(mask_ | !elements_);
         if (mask_) {
             removeAll();
+            DestroyArray(elements_, mask_ + 1);
             deallocate(elements_);
+            if (T_Probing::cCacheHashes) {
+                deallocate(hashes_);
+            }
         }
     }
 
+    // Capacity in slots, not entries (unlike the GroupProbing Set): the set grows once
+    // T_Probing::cMaxLoadEighths / 8 of them are full
     void reserve(size_t capacity) {
         if (capacity > mask_ + 1) {
             grow(capacity);
@@ -67,15 +81,15 @@ public:
     // Returned pointer is not stable!
     template<class... T_Params>
     T_Elem* add(T_Params&&... params) {
-        reserve(2 * ++count_);
+        reserve(GetCapacityFor(++count_));
         T_Elem elem(std::forward<T_Params>(params)...);
-        return store(std::move(elem));
+        return store(Hash(elem), std::move(elem));
     }
 
     // Returned pointer is not stable!
     T_Elem* add(T_Elem&& elem) {
-        reserve(2 * ++count_);
-        return store(std::move(elem));
+        reserve(GetCapacityFor(++count_));
+        return store(Hash(elem), std::move(elem));
     }
 
     template<class T_Key>
@@ -96,29 +110,47 @@ public:
     // Returned pointer is not stable!
     template<class T_Key>
     T_Elem* find(T_Key const& key) const {
-        unsigned slot = getBaseSlot(elem);
-        while (!IsNull(elements_[slot])) {
-            if (Equals(elements_[slot], key)) {
-                return elements_ + slot;
+        if (!mask_) {
+            return nullptr;
+        }
+        unsigned const slot = findSlot(key, Hash(key));
+        return slot <= mask_ ? elements_ + slot : nullptr;
+    }
+
+    // find() for each key, into results (pointers are not stable!). A batch of keys is hashed and their home
+    // slots prefetched before any is probed, so the cache misses overlap instead of being taken one at a time.
+    template<class T_Key>
+    void findBatch(Span<T_Key const> keys, Span<T_Elem*> results) const {
+        assert(results.count() == keys.count());
+        uint32_t hashes[cFindBatchSize];
+        for (unsigned first = 0; first < keys.count(); first += cFindBatchSize) {
+            unsigned const count = std::min(keys.count() - first, (unsigned)cFindBatchSize);
+            for (unsigned i = 0; i < count && mask_; i++) {
+                hashes[i] = Hash(keys[first + i]);
+                unsigned const slot = hashes[i] & mask_;
+                Prefetch(elements_ + slot); // (a hit compares the key even when the cached hash matched)
+                if (T_Probing::cCacheHashes) {
+                    Prefetch(hashes_ + slot);
+                }
+            }
+            for (unsigned i = 0; i < count; i++) {
+                unsigned const slot = mask_ ? findSlot(keys[first + i], hashes[i]) : 0;
+                results[first + i] = mask_ && slot <= mask_ ? elements_ + slot : nullptr;
             }
-            slot = (slot + 1) & mask_;
         }
-        return nullptr;
     }
 
     // Returned pointer is not stable!
     template<class... T_Params>
     T_Elem* findOrAdd(T_Elem&& elem) {
-        reserve(2 * (count_ + 1));
-        unsigned slot = getBaseSlot(elem);
-        while (!IsNull(elements_[slot])) {
-            if (Equals(elements_[slot], elem)) {
-                return elements_ + slot;
-            }
-            slot = (slot + 1) & mask_;
+        reserve(GetCapacityFor(count_ + 1));
+        uint32_t const hash = Hash(elem);
+        unsigned const slot = findSlot(elem, hash);
+        if (slot <= mask_) {
+            return elements_ + slot;
         }
         count_++;
-        return ConstructInPlace<T_Elem>(elements_ + slot, std::move(elem));
+        return store(hash, std::move(elem));
     }
 
     void removeAll() {
@@ -126,68 +158,149 @@ public:
             count_ = 0;
             for (size_t i = 0; i <= mask_; i++) {
                 if (!IsNull(elements_[i])) {
-                    T_Elem trashElem = std::move(elements_[i]);
+                    ReconstructInPlace(elements_[i]);
                 }
             }
         }
     }
 
+    ProbeStats getProbeStats() const {
+        return Internal::GetLinearProbeStats(count_, mask_,
+            [this](unsigned slot) { return !IsNull(elements_[slot]); },
+            [this](unsigned slot) { return getSlotHash(slot) & mask_; });
+    }
+
 private:
+    enum { cFindBatchSize = 16 };
+
     GG_NO_INLINE void grow(size_t requestedCapacity) {
         assert((unsigned)requestedCapacity > mask_ + 1);
         unsigned oldMask = std::exchange(mask_, NextPow2((unsigned)requestedCapacity) - 1);
         T_Elem* oldElements = std::exchange(elements_, (T_Elem*)allocate((mask_ + 1) * sizeof(T_Elem), alignof(T_Elem)));
+        uint32_t* oldHashes = hashes_;
+        if (T_Probing::cCacheHashes) {
+            hashes_ = (uint32_t*)allocate((mask_ + 1) * sizeof(uint32_t), alignof(uint32_t));
+        }
 
         ConstructArray<T_Elem>(elements_, mask_ + 1);
 
         if (oldMask) {
             for (size_t i = 0; i <= oldMask; i++) {
                 if (!IsNull(oldElements[i])) {
-                    store(std::move(oldElements[i]));
+                    uint32_t const hash = T_Probing::cCacheHashes ? oldHashes[i] : Hash(oldElements[i]);
+                    store(hash, std::move(oldElements[i]));
                 }
             }
+            DestroyArray(oldElements, oldMask + 1);
         }
 
         deallocate(oldElements);
+        if (T_Probing::cCacheHashes) {
+            deallocate(oldHashes);
+        }
+    }
+
+    static size_t GetCapacityFor(size_t count) {
+        return (count * 8 + T_Probing::cMaxLoadEighths - 1) / T_Probing::cMaxLoadEighths;
     }
 
-    T_Elem* store(T_Elem&& elem) const {
-        assert(2 * count_ <= mask_ + 1);
-        unsigned slot = getBaseSlot(elem);
-        while (!IsNull(elements_[slot])) {
+    T_Elem* store(uint32_t hash, T_Elem&& elem) const {
+        assert(count_ * 8 <= (mask_ + 1) * T_Probing::cMaxLoadEighths);
+        unsigned slot = getBaseSlot(elem, hash);
+        for (unsigned distance = 0; !IsNull(elements_[slot]); ++distance) {
             assert(!Equals(elements_[slot], elem)); // Already in set, use findOrAdd()
+            if (T_Probing::cRobinHood && getSlotDistance(slot) < distance) {
+                makeRoom(slot);
+                break;
+            }
             slot = (slot + 1) & mask_;
         }
-        return ConstructInPlace<T_Elem>(elements_ + slot, std::move(elem));
+        if (T_Probing::cCacheHashes) {
+            hashes_[slot] = hash;
+        }
+        return ReconstructInPlace(elements_[slot], std::move(elem));
+    }
+
+    // Moves the rest of the cluster from slot onwards one slot along, leaving slot empty
+    void makeRoom(unsigned slot) const {
+        unsigned empty = slot;
+        while (!IsNull(elements_[empty])) {
+            empty = (empty + 1) & mask_;
+        }
+        for (unsigned to = empty; to != slot; to = (to - 1) & mask_) {
+            unsigned const from = (to - 1) & mask_;
+            ReconstructInPlace(elements_[to], std::move(elements_[from]));
+            if (T_Probing::cCacheHashes) {
+                hashes_[to] = hashes_[from];
+            }
+        }
+        ReconstructInPlace(elements_[slot]);
     }
 
     T_Elem removeSlot(unsigned slot) {
         assert(slot <= mask_ && !IsNull(elements_[slot]));
         T_Elem removed = std::move(elements_[slot]);
         for (unsigned moving = (slot+1) & mask_; !IsNull(elements_[moving]); moving = (moving+1) & mask_) {
-            unsigned const target = getBaseSlot(elements_[moving]);
+            unsigned const target = getSlotHash(moving) & mask_;
             bool const a = target <= slot;
             bool const b = slot < moving;
             if (target <= moving ? (a & b) : (a | b)) {
                 ReconstructInPlace(elements_[slot], std::move(elements_[moving]));
+                if (T_Probing::cCacheHashes) {
+                    hashes_[slot] = hashes_[moving];
+                }
                 slot = moving;
             }
         }
+        // (A moved-from element isn't necessarily null)
+        ReconstructInPlace(elements_[slot]);
         count_--;
         return removed;
     }
 
     template<class T_Key>
-    unsigned getBaseSlot(T_Key const& key) const {
+    unsigned getBaseSlot(T_Key const& key, uint32_t hash) const {
         assert(!IsNull(key));
-        uint32_t hash = Hash(key);
         return hash & mask_;
     }
 
+    uint32_t getSlotHash(unsigned slot) const {
+        return T_Probing::cCacheHashes ? hashes_[slot] : Hash(elements_[slot]);
+    }
+
+    // How far a full slot is from its home slot
+    unsigned getSlotDistance(unsigned slot) const {
+        return (slot - getSlotHash(slot)) & mask_;
+    }
+
+    // Returns mask_ + 1 if not found. Robin Hood clusters are ordered by home slot, so the search can stop
+    // at the first element that is closer to home than the key would be.
+    template<class T_Key>
+    unsigned findSlot(T_Key const& key, uint32_t hash) const {
+        unsigned slot = getBaseSlot(key, hash);
+        for (unsigned distance = 0; !IsNull(elements_[slot]); ++distance) {
+            if (slotEquals(slot, key, hash)) {
+                return slot;
+            }
+            if (T_Probing::cRobinHood && getSlotDistance(slot) < distance) {
+                break;
+            }
+            slot = (slot + 1) & mask_;
+        }
+        return mask_ + 1;
+    }
+
+    // With cached hashes, elements are only compared when their hashes match
+    template<class T_Key>
+    bool slotEquals(unsigned slot, T_Key const& key, uint32_t hash) const {
+        return (!T_Probing::cCacheHashes || hashes_[slot] == hash) && Equals(elements_[slot], key);
+    }
+
     template<class T_Key>
     unsigned fetchSlot(T_Key const& key) const {
-        unsigned slot = getBaseSlot(key);
-        while (!Equals(elements_[slot], key)) {
+        uint32_t const hash = Hash(key);
+        unsigned slot = getBaseSlot(key, hash);
+        while (!slotEquals(slot, key, hash)) {
             assert(!IsNull(elements_[slot]));
             slot = (slot + 1) & mask_;
         }
@@ -209,12 +322,224 @@ private:
         return T_ElemTraits::KeyTraits::Hash(T_ElemTraits::GetKey(key));
     }
 
+    using Base::hashes_;            // (only with T_Probing::cCacheHashes)
     T_Elem* elements_ = nullptr;
     unsigned count_ = 0;
     unsigned mask_ = 0;
 
 };
 
+// Swiss-table style layout, see GroupProbing. Same interface as the linear-probing Set.
+template<class T_Elem, class T_ElemTraits, class T_Allocator>
+class Set<T_Elem, T_ElemTraits, T_Allocator, GroupProbing> : private T_Allocator {
+
+public:
+    Set() = default;
+    Set(std::nullptr_t)
+        : Set() {
+    }
+    explicit Set(size_t initialCount)
+        : Set() {
+        reserve(initialCount);
+    }
+    explicit Set(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    Set(Set&& src)
+        : T_Allocator(std::move(src))
+        , controls_(std::exchange(src.controls_, nullptr))
+        , elements_(std::exchange(src.elements_, nullptr))
+        , count_(std::exchange(src.count_, 0))
+        , growthLeft_(std::exchange(src.growthLeft_, 0))
+        , mask_(std::exchange(src.mask_, 0)) {
+    }
+    Set& operator=(Set&& src) {
+        ReconstructInPlace(*this, std::move(src));
+        return *this;
+    }
+    ~Set() {
+        if (controls_) {
+            removeAll();
+            deallocate(elements_);
+            deallocate(controls_);
+        }
+    }
+
+    // Makes room for this many elements (not slots, unlike the linear-probing Set) without rehashing
+    void reserve(size_t count) {
+        if (count > count_ + growthLeft_) {
+            rehash(std::max(Internal::GetGroupProbingCapacity(count), controls_ ? mask_ + 1 : 0));
+        }
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Elem* add(T_Params&&... params) {
+        T_Elem elem(std::forward<T_Params>(params)...);
+        return add(std::move(elem));
+    }
+
+    // Returned pointer is not stable!
+    T_Elem* add(T_Elem&& elem) {
+        uint32_t const hash = Hash(elem);
+        assert(!find(elem));    // Already in set, use findOrAdd()
+        unsigned const slot = prepareInsert(hash);
+        return ConstructInPlace<T_Elem>(elements_ + slot, std::move(elem));
+    }
+
+    template<class T_Key>
+    T_Elem remove(T_Key const& key) {
+        return remove(fetch(key));
+    }
+
+    T_Elem remove(T_Elem* found) {
+        unsigned const slot = (unsigned)(found - elements_);
+        assert(slot <= mask_ && !(controls_[slot] & Internal::cControlEmpty));
+        T_Elem removed = std::move(*found);
+        found->~T_Elem();
+        growthLeft_ += Internal::ReleaseGroupSlot(controls_, slot);
+        count_--;
+        return removed;
+    }
+
+    // Returned pointer is not stable!
+    template<class T_Key>
+    T_Elem* fetch(T_Key const& key) const {
+        T_Elem* const found = find(key);
+        assert(found);
+        return found;
+    }
+
+    // Returned pointer is not stable!
+    template<class T_Key>
+    T_Elem* find(T_Key const& key) const {
+        return controls_ ? findWithHash(key, Hash(key)) : nullptr;
+    }
+
+    // find() for each key, into results (pointers are not stable!). A batch of keys is hashed and their first
+    // control groups prefetched before any is probed, so the cache misses overlap.
+    template<class T_Key>
+    void findBatch(Span<T_Key const> keys, Span<T_Elem*> results) const {
+        assert(results.count() == keys.count());
+        uint32_t hashes[cFindBatchSize];
+        for (unsigned first = 0; first < keys.count(); first += cFindBatchSize) {
+            unsigned const count = std::min(keys.count() - first, (unsigned)cFindBatchSize);
+            for (unsigned i = 0; i < count && controls_; i++) {
+                hashes[i] = Hash(keys[first + i]);
+                Prefetch(controls_ + Internal::GroupProbeSequence(hashes[i], mask_).offset());
+            }
+            for (unsigned i = 0; i < count; i++) {
+                results[first + i] = controls_ ? findWithHash(keys[first + i], hashes[i]) : nullptr;
+            }
+        }
+    }
+
+    // Returned pointer is not stable!
+    T_Elem* findOrAdd(T_Elem&& elem) {
+        uint32_t const hash = Hash(elem);
+        if (controls_) {
+            if (T_Elem* const found = findWithHash(elem, hash)) {
+                return found;
+            }
+        }
+        unsigned const slot = prepareInsert(hash);
+        return ConstructInPlace<T_Elem>(elements_ + slot, std::move(elem));
+    }
+
+    void removeAll() {
+        if (controls_) {
+            for (unsigned slot = 0; slot <= mask_; slot++) {
+                if (!(controls_[slot] & Internal::cControlEmpty)) {
+                    elements_[slot].~T_Elem();
+                }
+            }
+            memset(controls_, Internal::cControlEmpty, mask_ + 1);
+            growthLeft_ = Internal::GetGroupProbingMaxUsed(mask_ + 1);
+            count_ = 0;
+        }
+    }
+
+private:
+    enum { cFindBatchSize = 16 };
+
+    template<class T_Key>
+    T_Elem* findWithHash(T_Key const& key, uint32_t hash) const {
+        uint8_t const tag = Internal::GetControlTag(hash);
+        for (Internal::GroupProbeSequence seq(hash, mask_); ; seq.next()) {
+            Internal::ControlGroup const group(controls_ + seq.offset());
+            for (uint32_t hits = group.match(tag); hits; hits &= hits - 1) {
+                unsigned const slot = seq.offset() + CountTrailingZeroBits(hits);
+                if (Equals(elements_[slot], key)) {
+                    return elements_ + slot;
+                }
+            }
+            if (group.matchEmpty()) {
+                return nullptr;
+            }
+        }
+    }
+
+    unsigned prepareInsert(uint32_t hash) {
+        if (growthLeft_ == 0) {
+            // Grow if genuinely full, otherwise rehash in place to clear out tombstones
+            unsigned const capacity = controls_ ? mask_ + 1 : 0;
+            rehash(count_ + 1 > Internal::GetGroupProbingMaxUsed(capacity) / 2 ? Internal::GetGroupProbingCapacity(2 * (count_ + 1)) : capacity);
+        }
+        unsigned const slot = Internal::FindGroupInsertSlot(controls_, mask_, hash);
+        growthLeft_ -= controls_[slot] == Internal::cControlEmpty;
+        controls_[slot] = Internal::GetControlTag(hash);
+        count_++;
+        return slot;
+    }
+
+    GG_NO_INLINE void rehash(unsigned capacity) {
+        unsigned const oldCapacity = controls_ ? mask_ + 1 : 0;
+        uint8_t* const oldControls = std::exchange(controls_, (uint8_t*)allocate(capacity, Internal::ControlGroup::cSlots));
+        T_Elem* const oldElements = std::exchange(elements_, (T_Elem*)allocate(capacity * sizeof(T_Elem), alignof(T_Elem)));
+        memset(controls_, Internal::cControlEmpty, capacity);
+        mask_ = capacity - 1;
+        growthLeft_ = Internal::GetGroupProbingMaxUsed(capacity) - count_;
+
+        for (unsigned i = 0; i < oldCapacity; i++) {
+            if (!(oldControls[i] & Internal::cControlEmpty)) {
+                uint32_t const hash = Hash(oldElements[i]);
+                unsigned const slot = Internal::FindGroupInsertSlot(controls_, mask_, hash);
+                controls_[slot] = Internal::GetControlTag(hash);
+                RelocateArray<T_Elem>(elements_ + slot, 1, oldElements + i);
+            }
+        }
+
+        if (oldControls) {
+            deallocate(oldElements);
+            deallocate(oldControls);
+        }
+    }
+
+    template<class T_Rhs>
+    static bool Equals(T_Elem const& a, T_Rhs const& b) {
+        return T_ElemTraits::KeyTraits::Equals(T_ElemTraits::GetKey(a), T_ElemTraits::GetKey(b));
+    }
+
+    template<class T_Key>
+    static uint32_t Hash(T_Key const& key) {
+        return T_ElemTraits::KeyTraits::Hash(T_ElemTraits::GetKey(key));
+    }
+
+    uint8_t* controls_ = nullptr;
+    T_Elem* elements_ = nullptr;
+    unsigned count_ = 0;
+    unsigned growthLeft_ = 0;
+    unsigned mask_ = 0;
+};
+
+template<class T_Elem, class T_ElemTraits, class T_Allocator, class T_Probing>
+struct IsTriviallyRelocatable<Set<T_Elem, T_ElemTraits, T_Allocator, T_Probing>> : IsTriviallyRelocatable<T_Allocator> {
+};
+
 }
 
 #endif
@@ -0,0 +1,127 @@
+#pragma once
+#ifndef GG_SHARDED_TABLE_H
+#define GG_SHARDED_TABLE_H
+
+#include "Table.h"
+#include "InlineArray.h"
+#include "SpinLock.h"
+#include <mutex>
+#include <thread>
+
+namespace gg {
+
+// Table for write-heavy use from many threads: keys are split by the top bits of their (remixed) hash into
+// independent shards, each a Table behind its own SpinLock, so threads only contend when they hit the same shard.
+// Values are only ever touched under their shard's lock, through callbacks.
+template<class T_Key, class T_Value, class T_KeyTraits = HashKeyTraitsDefault<T_Key>, class T_Allocator = Mallocator,
+    unsigned T_ShardBits = 5>
+class ShardedTable {
+
+    static_assert(T_ShardBits > 0 && T_ShardBits < 32, "Shards take the top T_ShardBits of a 32-bit hash");
+
+public:
+    enum { cShardCount = 1 << T_ShardBits };
+
+    ShardedTable() = default;
+    ShardedTable(ShardedTable const&) = delete;
+
+    // Calls update(value) under the shard lock, first adding the value (constructed from params) if the key is new.
+    // Returns what update returns.
+    template<class T_Update, class... T_Params>
+    auto findOrAdd(T_Key&& key, T_Update&& update, T_Params&&... params) -> decltype(update(std::declval<T_Value&>())) {
+        Shard& shard = getShard(key);
+        std::lock_guard<SpinLock> lock(shard.lock);
+        return update(*shard.table.findOrAdd(std::move(key), std::forward<T_Params>(params)...));
+    }
+
+    // Calls visit(value) under the shard lock if the key is present
+    template<class T_Visit>
+    bool find(T_Key const& key, T_Visit&& visit) const {
+        Shard& shard = getShard(key);
+        std::lock_guard<SpinLock> lock(shard.lock);
+        T_Value* const found = shard.table.find(key);
+        if (found) {
+            visit(*found);
+        }
+        return found != nullptr;
+    }
+
+    bool remove(T_Key const& key) {
+        Shard& shard = getShard(key);
+        std::lock_guard<SpinLock> lock(shard.lock);
+        T_Value* const found = shard.table.find(key);
+        if (found) {
+            shard.table.removeFound(found);
+        }
+        return found != nullptr;
+    }
+
+    // (A snapshot, if other threads are writing)
+    unsigned count() const {
+        unsigned count = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<SpinLock> lock(shard.lock);
+            count += shard.table.count();
+        }
+        return count;
+    }
+
+    // Calls visit(value) for every value, one shard lock at a time
+    template<class T_Visit>
+    void forEach(T_Visit const& visit) const {
+        for (Shard& shard : shards_) {
+            visitShard(shard, visit);
+        }
+    }
+
+    // forEach spread over threadCount threads (the caller included) that take shards as they go.
+    // visit must be safe to call concurrently for values in different shards.
+    template<class T_Visit>
+    void forEachParallel(T_Visit const& visit, unsigned threadCount) const {
+        std::atomic<unsigned> nextShard = {0};
+        auto worker = [&]() {
+            for (unsigned i; (i = nextShard.fetch_add(1, std::memory_order_relaxed)) < cShardCount; ) {
+                visitShard(shards_[i], visit);
+            }
+        };
+        threadCount = std::min(std::max(threadCount, 1u), (unsigned)cShardCount);
+        InlineArray<std::thread, 8> threads;
+        threads.reserve(threadCount - 1);
+        // (Joins whatever was started even if starting a thread or visit throws, rather than std::terminate)
+        GG_SCOPE_EXIT(
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        );
+        for (unsigned i = 0; i < threadCount - 1; i++) {
+            threads.addLast(worker);
+        }
+        worker();
+    }
+
+private:
+    struct alignas(64) Shard {
+        SpinLock lock;
+        Table<T_Key, T_Value, T_KeyTraits, T_Allocator> table;
+    };
+
+    // The hash is mixed first: hashes that only vary in their low bits (TrivialHashKeyTraits over small
+    // integers, say) would otherwise all land in shard 0. The shard Tables index with the low bits as they are.
+    Shard& getShard(T_Key const& key) const {
+        return shards_[Internal::HashFinalMix(T_KeyTraits::Hash(key)) >> (32 - T_ShardBits)];
+    }
+
+    template<class T_Visit>
+    static void visitShard(Shard& shard, T_Visit const& visit) {
+        std::lock_guard<SpinLock> lock(shard.lock);
+        for (T_Value& value : shard.table) {
+            visit(value);
+        }
+    }
+
+    mutable Shard shards_[cShardCount];
+};
+
+}
+
+#endif
@@ -2,8 +2,7 @@
 #ifndef GG_SPAN_H
 #define GG_SPAN_H
 
-#include <cassert>
-#include <algorithm>
+#include "MiscUtil.h"
 
 namespace gg {
 
@@ -71,6 +70,10 @@ private:
     size_t count_;
 };
 
+template<class T>
+struct IsTriviallyRelocatable<Span<T>> : std::true_type {
+};
+
 template<class T>
 Span<int8_t const> AsBytes(T* it) {
     return {(int8_t const*)it, sizeof(*it)};
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef GG_SPIN_LOCK_H
+#define GG_SPIN_LOCK_H
+
+#include "MiscUtil.h"
+#include <atomic>
+
+namespace gg {
+
+// For very short critical sections; waiters spin on a plain load so the line stays shared until it's released.
+// Works with std::lock_guard.
+class SpinLock {
+public:
+    SpinLock() = default;
+    SpinLock(SpinLock const&) = delete;
+
+    void lock() {
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                CpuRelax();
+            }
+        }
+    }
+
+    bool try_lock() {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> locked_ = {false};
+};
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#pragma once
+#ifndef GG_SPSC_RING_H
+#define GG_SPSC_RING_H
+
+#include "Allocator.h"
+#include "Span.h"
+#include "MiscUtil.h"
+#include <atomic>
+
+namespace gg {
+
+// Fixed-capacity Ring for handing items from one producer thread to one consumer thread without locks.
+// Positions run freely and are masked into the power-of-two buffer. Each side owns its position on its own
+// cache line, and keeps a stale copy of the other side's so it only rereads it when the ring looks full/empty.
+// add*/push* may only be called by the producer, remove*/pop* only by the consumer.
+// All the ordering there is: each side's release store of its position, after writing or reading the items,
+// pairs with the other side's acquire load of it, before reading or reusing them.
+template<class T, class T_Allocator = Mallocator>
+class SpscRing : private T_Allocator {
+
+public:
+    explicit SpscRing(size_t capacity, T_Allocator const& allocator = T_Allocator())
+        : T_Allocator(allocator)
+        , mask_(NextPow2((unsigned)capacity) - 1) {
+        data_ = (T*)allocate((mask_ + 1) * sizeof(T), alignof(T));
+    }
+    SpscRing(SpscRing const&) = delete;
+
+    ~SpscRing() {
+        unsigned const last = producer_.last.load(std::memory_order_relaxed);
+        for (unsigned i = consumer_.first.load(std::memory_order_relaxed); i != last; i++) {
+            data_[i & mask_].~T();
+        }
+        deallocate(data_);
+    }
+
+    unsigned capacity() const {
+        return mask_ + 1;
+    }
+
+    // (A snapshot, if the other side is running; first is read before last, so this never exceeds capacity())
+    unsigned count() const {
+        unsigned const first = consumer_.first.load(std::memory_order_acquire);
+        return producer_.last.load(std::memory_order_acquire) - first;
+    }
+
+    // Producer: false if full
+    template<class... T_Params>
+    bool tryAddLast(T_Params&&... params) {
+        unsigned const last = producer_.last.load(std::memory_order_relaxed);
+        if (!hasRoom(last, 1)) {
+            return false;
+        }
+        ConstructInPlace<T>(data_ + (last & mask_), std::forward<T_Params>(params)...);
+        producer_.last.store(last + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: copies in as many items as fit (the first of them), in at most two runs. Returns how many.
+    unsigned pushSpan(Span<T const> items) {
+        unsigned const last = producer_.last.load(std::memory_order_relaxed);
+        unsigned const count = std::min(items.count(), getRoom(last, items.count()));
+        unsigned const slot = last & mask_;
+        unsigned const frontCount = std::min(count, mask_ + 1 - slot);
+        CopyConstructArray<T>(data_ + slot, frontCount, items.begin());
+        CopyConstructArray<T>(data_, count - frontCount, items.begin() + frontCount);
+        producer_.last.store(last + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer: false if empty
+    bool tryRemoveFirst(T& out) {
+        unsigned const first = consumer_.first.load(std::memory_order_relaxed);
+        if (!hasItems(first, 1)) {
+            return false;
+        }
+        T& item = data_[first & mask_];
+        out = std::move(item);
+        item.~T();
+        consumer_.first.store(first + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: moves out as many items as are there, up to out.count(). Returns how many.
+    unsigned popSpan(Span<T> out) {
+        unsigned const first = consumer_.first.load(std::memory_order_relaxed);
+        unsigned const count = std::min(out.count(), getItems(first, out.count()));
+        unsigned const slot = first & mask_;
+        unsigned const frontCount = std::min(count, mask_ + 1 - slot);
+        MoveAssignArray(out.begin(), frontCount, data_ + slot);
+        MoveAssignArray(out.begin() + frontCount, count - frontCount, data_);
+        consumer_.first.store(first + count, std::memory_order_release);
+        return count;
+    }
+
+    struct Peeked {
+        Span<T> front;
+        Span<T> back;
+
+        unsigned count() const {
+            return front.count() + back.count();
+        }
+    };
+
+    // Consumer: the available items in place, as the part up to the end of the buffer and the part that wrapped
+    // (like Ring's frontSpan()/backSpan(), but both from one read of the producer's position, so they always
+    // agree). Release up to count() of them with removeFirstN().
+    Peeked peek() {
+        unsigned const first = consumer_.first.load(std::memory_order_relaxed);
+        unsigned const count = getItems(first, mask_ + 1);
+        unsigned const slot = first & mask_;
+        unsigned const frontCount = std::min(count, mask_ + 1 - slot);
+        return {Span<T>(data_ + slot, frontCount), Span<T>(data_, count - frontCount)};
+    }
+
+    void removeFirstN(unsigned n) {
+        unsigned const first = consumer_.first.load(std::memory_order_relaxed);
+        assert(hasItems(first, n));
+        for (unsigned i = 0; i < n; i++) {
+            data_[(first + i) & mask_].~T();
+        }
+        consumer_.first.store(first + n, std::memory_order_release);
+    }
+
+private:
+    bool hasRoom(unsigned last, unsigned n) {
+        return getRoom(last, n) >= n;
+    }
+
+    // At least n if there is room for that many, only rereading the consumer's position if needed
+    unsigned getRoom(unsigned last, unsigned n) {
+        unsigned room = mask_ + 1 - (last - producer_.cachedFirst);
+        if (room < n) {
+            producer_.cachedFirst = consumer_.first.load(std::memory_order_acquire);
+            room = mask_ + 1 - (last - producer_.cachedFirst);
+        }
+        return room;
+    }
+
+    bool hasItems(unsigned first, unsigned n) {
+        return getItems(first, n) >= n;
+    }
+
+    unsigned getItems(unsigned first, unsigned n) {
+        unsigned items = consumer_.cachedLast - first;
+        if (items < n) {
+            consumer_.cachedLast = producer_.last.load(std::memory_order_acquire);
+            items = consumer_.cachedLast - first;
+        }
+        return items;
+    }
+
+    struct alignas(64) Producer {
+        std::atomic<unsigned> last = {0};
+        unsigned cachedFirst = 0;
+    };
+
+    struct alignas(64) Consumer {
+        std::atomic<unsigned> first = {0};
+        unsigned cachedLast = 0;
+    };
+
+    T* data_ = nullptr;
+    unsigned const mask_;
+    Producer producer_;
+    Consumer consumer_;
+};
+
+}
+
+#endif
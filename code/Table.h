@@ -4,11 +4,16 @@
 
 #include "Allocator.h"
 #include "Hash.h"
+#include "HashProbing.h"
+#include "Span.h"
 
 namespace gg {
 
-template<class T_Key, class T_Value, class T_KeyTraits = HashKeyTraitsDefault<T_Key>, class T_Allocator = Mallocator>
-class Table : private T_Allocator {
+template<class T_Key, class T_Value, class T_KeyTraits = HashKeyTraitsDefault<T_Key>, class T_Allocator = Mallocator,
+    class T_Probing = LinearProbing>
+class Table : private Internal::LinearProbingBase<T_Allocator, T_Probing::cCacheHashes != 0> {
+
+    using Base = Internal::LinearProbingBase<T_Allocator, T_Probing::cCacheHashes != 0>;
 
 public:
     class Iterator;
@@ -18,8 +23,11 @@ public:
         : Table() {
         reserve(initialCapacity);
     }
+    explicit Table(T_Allocator const& allocator)
+        : Base(allocator) {
+    }
     Table(Table&& src)
-        : T_Allocator(std::move(src))
+        : Base(std::move(src))
         , keys_(std::exchange(src.keys_, nullptr))
         , values_(std::exchange(src.values_, nullptr))
         , count_(std::exchange(src.count_, 0))
@@ -32,9 +40,14 @@ public:
             DestroyArray(keys_, mask_ + 1);
             deallocate(values_);
             deallocate(keys_);
+            if (T_Probing::cCacheHashes) {
+                deallocate(hashes_);
+            }
         }
     }
 
+    // Capacity in slots, not entries (unlike the GroupProbing and DenseProbing Tables): the table grows once
+    // T_Probing::cMaxLoadEighths / 8 of them are full
     void reserve(size_t capacity) {
         if (capacity > mask_ + 1) {
             grow(capacity);
@@ -42,14 +55,16 @@ public:
     }
 
     Iterator begin() const {
-        unsigned slot;
-        for (slot = 0; slot <= mask_ && T_KeyTraits::IsNull(keys_[slot]); ++slot) {
+        unsigned slot = 0;
+        if (mask_) {
+            for (; slot <= mask_ && T_KeyTraits::IsNull(keys_[slot]); ++slot) {
+            }
         }
         return {*this, slot};
     }
 
     Iterator end() const {
-        return {*this, mask_ + 1};
+        return {*this, mask_ ? mask_ + 1 : 0};
     }
 
     unsigned count() const {
@@ -59,14 +74,14 @@ public:
     // Returned pointer is not stable!
     template<class... T_Params>
     T_Value* add(T_Key&& key, T_Params&&... params) {
-        reserve(2 * ++count_);
-        return store(std::move(key), std::forward<T_Params>(params)...);
+        reserve(GetCapacityFor(++count_));
+        return store(T_KeyTraits::Hash(key), std::move(key), std::forward<T_Params>(params)...);
     }
 
     // Returned pointer is not stable!
     T_Value* add(T_Key&& key, T_Value&& src) {
-        reserve(2 * ++count_);
-        return store(std::move(key), std::move(src));
+        reserve(GetCapacityFor(++count_));
+        return store(T_KeyTraits::Hash(key), std::move(key), std::move(src));
     }
 
     template<class... T_Params>
@@ -89,30 +104,46 @@ public:
 
     // Returned pointer is not stable!
     T_Value* find(T_Key const& key) const {
-        unsigned slot = getBaseSlot(key);
-        while (!T_KeyTraits::IsNull(keys_[slot])) {
-            if (T_KeyTraits::Equals(keys_[slot], key)) {
-                return values_ + slot;
+        if (!mask_) {
+            return nullptr;
+        }
+        unsigned const slot = findSlot(key, T_KeyTraits::Hash(key));
+        return slot <= mask_ ? values_ + slot : nullptr;
+    }
+
+    // find() for each key, into results (pointers are not stable!). A batch of keys is hashed and their home
+    // slots prefetched before any is probed, so the cache misses overlap instead of being taken one at a time.
+    void findBatch(Span<T_Key const> keys, Span<T_Value*> results) const {
+        assert(results.count() == keys.count());
+        uint32_t hashes[cFindBatchSize];
+        for (unsigned first = 0; first < keys.count(); first += cFindBatchSize) {
+            unsigned const count = std::min(keys.count() - first, (unsigned)cFindBatchSize);
+            for (unsigned i = 0; i < count && mask_; i++) {
+                hashes[i] = T_KeyTraits::Hash(keys[first + i]);
+                unsigned const slot = hashes[i] & mask_;
+                Prefetch(keys_ + slot);     // (a hit compares the key even when the cached hash matched)
+                if (T_Probing::cCacheHashes) {
+                    Prefetch(hashes_ + slot);
+                }
+            }
+            for (unsigned i = 0; i < count; i++) {
+                unsigned const slot = mask_ ? findSlot(keys[first + i], hashes[i]) : 0;
+                results[first + i] = mask_ && slot <= mask_ ? values_ + slot : nullptr;
             }
-            slot = (slot + 1) & mask_;
         }
-        return nullptr;
     }
 
     // Returned pointer is not stable!
     template<class... T_Params>
     T_Value* findOrAdd(T_Key&& key, T_Params&&... params) {
-        reserve(2 * (count_ + 1));
-        unsigned slot = getBaseSlot(key);
-        while (!T_KeyTraits::IsNull(keys_[slot])) {
-            if (T_KeyTraits::Equals(keys_[slot], key)) {
-                return values_ + slot;
-            }
-            slot = (slot + 1) & mask_;
+        reserve(GetCapacityFor(count_ + 1));
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        unsigned const slot = findSlot(key, hash);
+        if (slot <= mask_) {
+            return values_ + slot;
         }
         count_++;
-        ConstructInPlace<T_Key>(keys_ + slot, std::move(key));
-        return ConstructInPlace<T_Value>(values_ + slot, std::forward<T_Params>(params)...);
+        return store(hash, std::move(key), std::forward<T_Params>(params)...);
     }
 
     void removeAll() {
@@ -120,87 +151,180 @@ public:
             count_ = 0;
             for (size_t i = 0; i <= mask_; i++) {
                 if (!T_KeyTraits::IsNull(keys_[i])) {
-                    T_Key trashKey = std::move(keys_[i]);
+                    ReconstructInPlace(keys_[i]);
                     values_[i].~T_Value();
                 }
             }
         }
     }
 
+    ProbeStats getProbeStats() const {
+        return Internal::GetLinearProbeStats(count_, mask_,
+            [this](unsigned slot) { return !T_KeyTraits::IsNull(keys_[slot]); },
+            [this](unsigned slot) { return getSlotHash(slot) & mask_; });
+    }
+
 private:
+    enum { cFindBatchSize = 16 };
+
     GG_NO_INLINE void grow(size_t requestedCapacity) {
         assert((unsigned)requestedCapacity > mask_ + 1);
         unsigned oldMask = std::exchange(mask_, NextPow2((unsigned)requestedCapacity) - 1);
         T_Key* oldKeys = std::exchange(keys_, (T_Key*)allocate((mask_ + 1) * sizeof(T_Key), alignof(T_Key)));
         T_Value* oldValues = std::exchange(values_, (T_Value*)allocate((mask_ + 1) * sizeof(T_Value), alignof(T_Value)));
+        uint32_t* oldHashes = hashes_;
+        if (T_Probing::cCacheHashes) {
+            hashes_ = (uint32_t*)allocate((mask_ + 1) * sizeof(uint32_t), alignof(uint32_t));
+        }
 
         ConstructArray<T_Key>(keys_, mask_ + 1);
 
         if (oldMask) {
             for (size_t i = 0; i <= oldMask; i++) {
                 if (!T_KeyTraits::IsNull(oldKeys[i])) {
-                    store(std::move(oldKeys[i]), std::move(oldValues[i]));
+                    uint32_t const hash = T_Probing::cCacheHashes ? oldHashes[i] : T_KeyTraits::Hash(oldKeys[i]);
+                    store(hash, std::move(oldKeys[i]), std::move(oldValues[i]));
+                    oldValues[i].~T_Value();
                 }
             }
+            DestroyArray(oldKeys, oldMask + 1);
         }
 
         deallocate(oldValues);
         deallocate(oldKeys);
+        if (T_Probing::cCacheHashes) {
+            deallocate(oldHashes);
+        }
+    }
+
+    static size_t GetCapacityFor(size_t count) {
+        return (count * 8 + T_Probing::cMaxLoadEighths - 1) / T_Probing::cMaxLoadEighths;
     }
 
     template<class... T_Params>
-    T_Value* store(T_Key&& key, T_Params&&... params) const {
-        assert(2 * count_ <= mask_ + 1);
-        unsigned slot = getBaseSlot(key);
-        while (!T_KeyTraits::IsNull(keys_[slot])) {
+    T_Value* store(uint32_t hash, T_Key&& key, T_Params&&... params) const {
+        assert(count_ * 8 <= (mask_ + 1) * T_Probing::cMaxLoadEighths);
+        unsigned slot = getBaseSlot(key, hash);
+        for (unsigned distance = 0; !T_KeyTraits::IsNull(keys_[slot]); ++distance) {
             assert(!T_KeyTraits::Equals(keys_[slot], key));  // Already in table, use findOrAdd()
+            if (T_Probing::cRobinHood && getSlotDistance(slot) < distance) {
+                makeRoom(slot);
+                break;
+            }
             slot = (slot + 1) & mask_;
         }
+        if (T_Probing::cCacheHashes) {
+            hashes_[slot] = hash;
+        }
         ConstructInPlace<T_Key>(keys_ + slot, std::move(key));
         return ConstructInPlace<T_Value>(values_ + slot, std::forward<T_Params>(params)...);
     }
 
+    // Moves the rest of the cluster from slot onwards one slot along, leaving slot empty
+    void makeRoom(unsigned slot) const {
+        unsigned empty = slot;
+        while (!T_KeyTraits::IsNull(keys_[empty])) {
+            empty = (empty + 1) & mask_;
+        }
+        ConstructInPlace<T_Value>(values_ + empty, std::move(values_[(empty - 1) & mask_]));
+        for (unsigned to = empty; to != slot; to = (to - 1) & mask_) {
+            unsigned const from = (to - 1) & mask_;
+            ReconstructInPlace(keys_[to], std::move(keys_[from]));
+            if (to != empty) {
+                ReconstructInPlace(values_[to], std::move(values_[from]));
+            }
+            if (T_Probing::cCacheHashes) {
+                hashes_[to] = hashes_[from];
+            }
+        }
+        ReconstructInPlace(keys_[slot]);
+        values_[slot].~T_Value();
+    }
+
     T_Value removeSlot(unsigned slot) {
         assert(slot <= mask_ && !T_KeyTraits::IsNull(keys_[slot]));
         T_Value removed = std::move(values_[slot]);
-        T_Key trashKey = std::move(keys_[slot]);
         for (unsigned moving = (slot+1) & mask_; !T_KeyTraits::IsNull(keys_[moving]); moving = (moving+1) & mask_) {
-            unsigned const target = getBaseSlot(keys_[moving]);
+            unsigned const target = getSlotHash(moving) & mask_;
             bool const a = target <= slot;
             bool const b = slot < moving;
             if (target <= moving ? (a & b) : (a | b)) {
                 ReconstructInPlace(keys_[slot], std::move(keys_[moving]));
                 ReconstructInPlace(values_[slot], std::move(values_[moving]));
+                if (T_Probing::cCacheHashes) {
+                    hashes_[slot] = hashes_[moving];
+                }
                 slot = moving;
             }
         }
+        // (A moved-from key isn't necessarily null)
+        ReconstructInPlace(keys_[slot]);
+        values_[slot].~T_Value();
         count_--;
         return removed;
     }
 
-    unsigned getBaseSlot(T_Key const& key) const {
+    unsigned getBaseSlot(T_Key const& key, uint32_t hash) const {
         assert(!T_KeyTraits::IsNull(key));
-        uint32_t hash = T_KeyTraits::Hash(key);
         return hash & mask_;
     }
 
+    uint32_t getSlotHash(unsigned slot) const {
+        return T_Probing::cCacheHashes ? hashes_[slot] : T_KeyTraits::Hash(keys_[slot]);
+    }
+
+    // How far a full slot is from its home slot
+    unsigned getSlotDistance(unsigned slot) const {
+        return (slot - getSlotHash(slot)) & mask_;
+    }
+
+    // Returns mask_ + 1 if not found. Robin Hood clusters are ordered by home slot, so the search can stop
+    // at the first entry that is closer to home than the key would be.
+    unsigned findSlot(T_Key const& key, uint32_t hash) const {
+        unsigned slot = getBaseSlot(key, hash);
+        for (unsigned distance = 0; !T_KeyTraits::IsNull(keys_[slot]); ++distance) {
+            if (slotEquals(slot, key, hash)) {
+                return slot;
+            }
+            if (T_Probing::cRobinHood && getSlotDistance(slot) < distance) {
+                break;
+            }
+            slot = (slot + 1) & mask_;
+        }
+        return mask_ + 1;
+    }
+
+    // With cached hashes, keys are only compared when their hashes match
+    bool slotEquals(unsigned slot, T_Key const& key, uint32_t hash) const {
+        return (!T_Probing::cCacheHashes || hashes_[slot] == hash) && T_KeyTraits::Equals(keys_[slot], key);
+    }
+
     unsigned fetchSlot(T_Key const& key) const {
-        unsigned slot = getBaseSlot(key);
-        while (!T_KeyTraits::Equals(keys_[slot], key)) {
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        unsigned slot = getBaseSlot(key, hash);
+        while (!slotEquals(slot, key, hash)) {
             assert(!T_KeyTraits::IsNull(keys_[slot]));
             slot = (slot + 1) & mask_;
         }
         return slot;
     }
 
+    template<class, class, class, class, class>
+    friend class Table;
+
+    using Base::hashes_;            // (only with T_Probing::cCacheHashes)
     T_Key* keys_ = nullptr;
     T_Value* values_ = nullptr;
     unsigned count_ = 0;
     unsigned mask_ = 0;
 };
 
-template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator>
-class Table<T_Key, T_Value, T_KeyTraits, T_Allocator>::Iterator {
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator, class T_Probing>
+struct IsTriviallyRelocatable<Table<T_Key, T_Value, T_KeyTraits, T_Allocator, T_Probing>> : IsTriviallyRelocatable<T_Allocator> {
+};
+
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator, class T_Probing>
+class Table<T_Key, T_Value, T_KeyTraits, T_Allocator, T_Probing>::Iterator {
 public:
     Iterator(Table const& table, unsigned slot)
         : table_(table)
@@ -223,6 +347,729 @@ private:
     unsigned slot_;
 };
 
+// Swiss-table style layout, see GroupProbing. Same interface as the linear-probing Table.
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator>
+class Table<T_Key, T_Value, T_KeyTraits, T_Allocator, GroupProbing> : private T_Allocator {
+
+public:
+    class Iterator;
+
+    Table() = default;
+    explicit Table(size_t initialCount)
+        : Table() {
+        reserve(initialCount);
+    }
+    explicit Table(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    Table(Table&& src)
+        : T_Allocator(std::move(src))
+        , controls_(std::exchange(src.controls_, nullptr))
+        , keys_(std::exchange(src.keys_, nullptr))
+        , values_(std::exchange(src.values_, nullptr))
+        , count_(std::exchange(src.count_, 0))
+        , growthLeft_(std::exchange(src.growthLeft_, 0))
+        , mask_(std::exchange(src.mask_, 0)) {
+    }
+    ~Table() {
+        if (controls_) {
+            removeAll();
+            deallocate(values_);
+            deallocate(keys_);
+            deallocate(controls_);
+        }
+    }
+
+    // Makes room for this many entries (not slots, unlike the linear-probing Table) without rehashing
+    void reserve(size_t count) {
+        if (count > count_ + growthLeft_) {
+            rehash(std::max(Internal::GetGroupProbingCapacity(count), controls_ ? mask_ + 1 : 0));
+        }
+    }
+
+    Iterator begin() const {
+        return {*this, nextFullSlot(0)};
+    }
+
+    Iterator end() const {
+        return {*this, controls_ ? mask_ + 1 : 0};
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Value* add(T_Key&& key, T_Params&&... params) {
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        assert(!find(key));     // Already in table, use findOrAdd()
+        unsigned const slot = prepareInsert(hash);
+        ConstructInPlace<T_Key>(keys_ + slot, std::move(key));
+        return ConstructInPlace<T_Value>(values_ + slot, std::forward<T_Params>(params)...);
+    }
+
+    // Returned pointer is not stable!
+    T_Value* add(T_Key&& key, T_Value&& src) {
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        assert(!find(key));     // Already in table, use findOrAdd()
+        unsigned const slot = prepareInsert(hash);
+        ConstructInPlace<T_Key>(keys_ + slot, std::move(key));
+        return ConstructInPlace<T_Value>(values_ + slot, std::move(src));
+    }
+
+    T_Value remove(T_Key const& key) {
+        T_Value* const found = find(key);
+        assert(found);
+        return removeSlot((unsigned)(found - values_));
+    }
+
+    T_Value removeFound(T_Value* found) {
+        return removeSlot((unsigned)(found - values_));
+    }
+
+    // Returned pointer is not stable!
+    T_Value* fetch(T_Key const& key) const {
+        T_Value* const found = find(key);
+        assert(found);
+        return found;
+    }
+
+    // Returned pointer is not stable!
+    T_Value* find(T_Key const& key) const {
+        return controls_ ? findWithHash(key, T_KeyTraits::Hash(key)) : nullptr;
+    }
+
+    // find() for each key, into results (pointers are not stable!). A batch of keys is hashed and their first
+    // control groups prefetched before any is probed, so the cache misses overlap.
+    void findBatch(Span<T_Key const> keys, Span<T_Value*> results) const {
+        assert(results.count() == keys.count());
+        uint32_t hashes[cFindBatchSize];
+        for (unsigned first = 0; first < keys.count(); first += cFindBatchSize) {
+            unsigned const count = std::min(keys.count() - first, (unsigned)cFindBatchSize);
+            for (unsigned i = 0; i < count && controls_; i++) {
+                hashes[i] = T_KeyTraits::Hash(keys[first + i]);
+                Prefetch(controls_ + Internal::GroupProbeSequence(hashes[i], mask_).offset());
+            }
+            for (unsigned i = 0; i < count; i++) {
+                results[first + i] = controls_ ? findWithHash(keys[first + i], hashes[i]) : nullptr;
+            }
+        }
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Value* findOrAdd(T_Key&& key, T_Params&&... params) {
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        if (controls_) {
+            if (T_Value* const found = findWithHash(key, hash)) {
+                return found;
+            }
+        }
+        unsigned const slot = prepareInsert(hash);
+        ConstructInPlace<T_Key>(keys_ + slot, std::move(key));
+        return ConstructInPlace<T_Value>(values_ + slot, std::forward<T_Params>(params)...);
+    }
+
+    void removeAll() {
+        if (controls_) {
+            for (unsigned slot = nextFullSlot(0); slot <= mask_; slot = nextFullSlot(slot + 1)) {
+                values_[slot].~T_Value();
+                keys_[slot].~T_Key();
+            }
+            memset(controls_, Internal::cControlEmpty, mask_ + 1);
+            growthLeft_ = Internal::GetGroupProbingMaxUsed(mask_ + 1);
+            count_ = 0;
+        }
+    }
+
+private:
+    enum { cFindBatchSize = 16 };
+
+    T_Value* findWithHash(T_Key const& key, uint32_t hash) const {
+        uint8_t const tag = Internal::GetControlTag(hash);
+        for (Internal::GroupProbeSequence seq(hash, mask_); ; seq.next()) {
+            Internal::ControlGroup const group(controls_ + seq.offset());
+            for (uint32_t hits = group.match(tag); hits; hits &= hits - 1) {
+                unsigned const slot = seq.offset() + CountTrailingZeroBits(hits);
+                if (T_KeyTraits::Equals(keys_[slot], key)) {
+                    return values_ + slot;
+                }
+            }
+            if (group.matchEmpty()) {
+                return nullptr;
+            }
+        }
+    }
+
+    unsigned prepareInsert(uint32_t hash) {
+        if (growthLeft_ == 0) {
+            // Grow if genuinely full, otherwise rehash in place to clear out tombstones
+            unsigned const capacity = controls_ ? mask_ + 1 : 0;
+            rehash(count_ + 1 > Internal::GetGroupProbingMaxUsed(capacity) / 2 ? Internal::GetGroupProbingCapacity(2 * (count_ + 1)) : capacity);
+        }
+        unsigned const slot = Internal::FindGroupInsertSlot(controls_, mask_, hash);
+        growthLeft_ -= controls_[slot] == Internal::cControlEmpty;
+        controls_[slot] = Internal::GetControlTag(hash);
+        count_++;
+        return slot;
+    }
+
+    T_Value removeSlot(unsigned slot) {
+        assert(slot <= mask_ && !(controls_[slot] & Internal::cControlEmpty));
+        T_Value removed = std::move(values_[slot]);
+        values_[slot].~T_Value();
+        keys_[slot].~T_Key();
+        growthLeft_ += Internal::ReleaseGroupSlot(controls_, slot);
+        count_--;
+        return removed;
+    }
+
+    GG_NO_INLINE void rehash(unsigned capacity) {
+        unsigned const oldCapacity = controls_ ? mask_ + 1 : 0;
+        uint8_t* const oldControls = std::exchange(controls_, (uint8_t*)allocate(capacity, Internal::ControlGroup::cSlots));
+        T_Key* const oldKeys = std::exchange(keys_, (T_Key*)allocate(capacity * sizeof(T_Key), alignof(T_Key)));
+        T_Value* const oldValues = std::exchange(values_, (T_Value*)allocate(capacity * sizeof(T_Value), alignof(T_Value)));
+        memset(controls_, Internal::cControlEmpty, capacity);
+        mask_ = capacity - 1;
+        growthLeft_ = Internal::GetGroupProbingMaxUsed(capacity) - count_;
+
+        for (unsigned i = 0; i < oldCapacity; i++) {
+            if (!(oldControls[i] & Internal::cControlEmpty)) {
+                uint32_t const hash = T_KeyTraits::Hash(oldKeys[i]);
+                unsigned const slot = Internal::FindGroupInsertSlot(controls_, mask_, hash);
+                controls_[slot] = Internal::GetControlTag(hash);
+                RelocateArray<T_Key>(keys_ + slot, 1, oldKeys + i);
+                RelocateArray<T_Value>(values_ + slot, 1, oldValues + i);
+            }
+        }
+
+        if (oldControls) {
+            deallocate(oldValues);
+            deallocate(oldKeys);
+            deallocate(oldControls);
+        }
+    }
+
+    unsigned nextFullSlot(unsigned slot) const {
+        unsigned const end = controls_ ? mask_ + 1 : 0;
+        while (slot < end && (controls_[slot] & Internal::cControlEmpty)) {
+            ++slot;
+        }
+        return slot;
+    }
+
+    uint8_t* controls_ = nullptr;
+    T_Key* keys_ = nullptr;
+    T_Value* values_ = nullptr;
+    unsigned count_ = 0;
+    unsigned growthLeft_ = 0;
+    unsigned mask_ = 0;
+};
+
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator>
+class Table<T_Key, T_Value, T_KeyTraits, T_Allocator, GroupProbing>::Iterator {
+public:
+    Iterator(Table const& table, unsigned slot)
+        : table_(table)
+        , slot_(slot) {
+    }
+    bool operator!=(Iterator const& rhs) const {
+        return slot_ != rhs.slot_;
+    }
+    Iterator& operator++() {
+        slot_ = table_.nextFullSlot(slot_ + 1);
+        return *this;
+    }
+    T_Value& operator*() const {
+        assert(slot_ <= table_.mask_);
+        return table_.values_[slot_];
+    }
+private:
+    Table const& table_;
+    unsigned slot_;
+};
+
+// Two linear-probing tables: while growing, new entries go into current_ and each add/remove first moves
+// some of old_ across. Moves happen a whole cluster at a time, so the part of old_ that is left keeps valid
+// probe sequences and lookups can simply try both. Lookups don't migrate (they stay const).
+// The add that starts a migration still allocates current_ and constructs all its null keys in one go: O(new
+// capacity), much cheaper than rehashing every entry but not spread out. Use reserve() to avoid it entirely.
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator, class T_Inner>
+class Table<T_Key, T_Value, T_KeyTraits, T_Allocator, IncrementalProbing<T_Inner>> {
+
+    using Linear = Table<T_Key, T_Value, T_KeyTraits, T_Allocator, T_Inner>;
+
+public:
+    class Iterator;
+
+    enum {
+        cMigrateSlotsPerOp = 8,     // (must be > 2 so migration finishes before current_ fills up)
+        cMinIncrementalCapacity = 64,
+    };
+
+    Table() = default;
+    explicit Table(size_t initialCapacity)
+        : Table() {
+        reserve(initialCapacity);
+    }
+    explicit Table(T_Allocator const& allocator)
+        : current_(allocator)
+        , old_(allocator) {
+    }
+    Table(Table&& src)
+        : current_(std::move(src.current_))
+        , old_(std::move(src.old_))
+        , migrateStart_(src.migrateStart_)
+        , migrated_(src.migrated_) {
+    }
+
+    // Blocking: finishes any migration first. Capacity in slots, as with T_Inner.
+    void reserve(size_t capacity) {
+        finishMigration();
+        current_.reserve(capacity);
+    }
+
+    Iterator begin() const {
+        return {*this, nextSlot(0)};
+    }
+
+    Iterator end() const {
+        return {*this, getSlotCount()};
+    }
+
+    unsigned count() const {
+        return current_.count_ + old_.count_;
+    }
+
+    bool isMigrating() const {
+        return old_.mask_ != 0;
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Value* add(T_Key&& key, T_Params&&... params) {
+        assert(!old_.mask_ || !old_.find(key));     // Already in table, use findOrAdd()
+        prepareAdd();
+        return current_.add(std::move(key), std::forward<T_Params>(params)...);
+    }
+
+    // Returned pointer is not stable!
+    T_Value* add(T_Key&& key, T_Value&& src) {
+        assert(!old_.mask_ || !old_.find(key));     // Already in table, use findOrAdd()
+        prepareAdd();
+        return current_.add(std::move(key), std::move(src));
+    }
+
+    T_Value remove(T_Key const& key) {
+        T_Value* const found = find(key);
+        assert(found);
+        return removeFound(found);
+    }
+
+    T_Value removeFound(T_Value* found) {
+        // (Removing from old_ backward-shifts within one unmigrated cluster, which never crosses the migrated part)
+        T_Value removed = isInCurrent(found) ? current_.removeFound(found) : old_.removeFound(found);
+        migrate(cMigrateSlotsPerOp);
+        return removed;
+    }
+
+    // Returned pointer is not stable!
+    T_Value* fetch(T_Key const& key) const {
+        T_Value* const found = find(key);
+        assert(found);
+        return found;
+    }
+
+    // Returned pointer is not stable!
+    T_Value* find(T_Key const& key) const {
+        T_Value* const found = current_.mask_ ? current_.find(key) : nullptr;
+        return found || !old_.mask_ ? found : old_.find(key);
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Value* findOrAdd(T_Key&& key, T_Params&&... params) {
+        if (T_Value* const found = find(key)) {
+            return found;
+        }
+        prepareAdd();
+        return current_.add(std::move(key), std::forward<T_Params>(params)...);
+    }
+
+    void removeAll() {
+        current_.removeAll();
+        releaseOld();
+    }
+
+private:
+    bool isInCurrent(T_Value const* value) const {
+        return value >= current_.values_ && value <= current_.values_ + current_.mask_;
+    }
+
+    void prepareAdd() {
+        if (old_.mask_) {
+            migrate(cMigrateSlotsPerOp);
+        } else if (current_.mask_ + 1 >= cMinIncrementalCapacity
+            && Linear::GetCapacityFor(current_.count_ + 1) > current_.mask_ + 1) {
+            startMigration();
+        }
+        // (Small tables just grow in one go)
+        assert(!old_.mask_ || Linear::GetCapacityFor(current_.count_ + 1) <= current_.mask_ + 1);
+    }
+
+    GG_NO_INLINE void startMigration() {
+        unsigned const capacity = 2 * (current_.mask_ + 1);
+        ReconstructInPlace(old_, std::move(current_));
+        ReconstructInPlace(current_, static_cast<T_Allocator const&>(old_));
+        current_.reserve(capacity);
+        // Start just after an empty slot so no cluster straddles the start (there always is one, below cMaxLoadEighths)
+        for (migrateStart_ = 0; !T_KeyTraits::IsNull(old_.keys_[migrateStart_]); ++migrateStart_) {
+        }
+        migrated_ = 0;
+        migrate(cMigrateSlotsPerOp);
+    }
+
+    // Moves entries from old_ until at least this many slots were visited, stopping only between clusters
+    void migrate(unsigned slots) {
+        if (!old_.mask_) {
+            return;
+        }
+        unsigned const oldCapacity = old_.mask_ + 1;
+        while (migrated_ < oldCapacity) {
+            unsigned const slot = (migrateStart_ + migrated_) & old_.mask_;
+            if (T_KeyTraits::IsNull(old_.keys_[slot])) {
+                if (slots == 0) {
+                    return;
+                }
+            } else {
+                current_.count_++;
+                current_.store(old_.getSlotHash(slot), std::move(old_.keys_[slot]), std::move(old_.values_[slot]));
+                ReconstructInPlace(old_.keys_[slot]);
+                old_.values_[slot].~T_Value();
+                old_.count_--;
+            }
+            migrated_++;
+            slots -= slots > 0;
+        }
+        assert(old_.count_ == 0);
+        releaseOld();
+    }
+
+    void finishMigration() {
+        migrate(old_.mask_ + 1);
+    }
+
+    void releaseOld() {
+        T_Allocator const allocator = static_cast<T_Allocator const&>(old_);
+        ReconstructInPlace(old_, allocator);
+    }
+
+    unsigned getSlotCount() const {
+        return (current_.mask_ ? current_.mask_ + 1 : 0) + (old_.mask_ ? old_.mask_ + 1 : 0);
+    }
+
+    // Slots of current_ come first, then those of old_
+    T_Key const& getSlotKey(unsigned slot, T_Value** value) const {
+        unsigned const currentSlots = current_.mask_ ? current_.mask_ + 1 : 0;
+        Linear const& table = slot < currentSlots ? current_ : old_;
+        slot -= slot < currentSlots ? 0 : currentSlots;
+        *value = table.values_ + slot;
+        return table.keys_[slot];
+    }
+
+    unsigned nextSlot(unsigned slot) const {
+        T_Value* value;
+        unsigned const end = getSlotCount();
+        while (slot < end && T_KeyTraits::IsNull(getSlotKey(slot, &value))) {
+            ++slot;
+        }
+        return slot;
+    }
+
+    Linear current_;
+    Linear old_;
+    unsigned migrateStart_ = 0;
+    unsigned migrated_ = 0;
+};
+
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator, class T_Inner>
+class Table<T_Key, T_Value, T_KeyTraits, T_Allocator, IncrementalProbing<T_Inner>>::Iterator {
+public:
+    Iterator(Table const& table, unsigned slot)
+        : table_(table)
+        , slot_(slot) {
+    }
+    bool operator!=(Iterator const& rhs) const {
+        return slot_ != rhs.slot_;
+    }
+    Iterator& operator++() {
+        slot_ = table_.nextSlot(slot_ + 1);
+        return *this;
+    }
+    T_Value& operator*() const {
+        T_Value* value;
+        table_.getSlotKey(slot_, &value);
+        return *value;
+    }
+private:
+    Table const& table_;
+    unsigned slot_;
+};
+
+// See DenseProbing. Entries stay in insertion order until something is removed. The index caches each entry's
+// hash next to it, so probes and regrowing the index never rehash or compare keys needlessly.
+template<class T_Key, class T_Value, class T_KeyTraits, class T_Allocator>
+class Table<T_Key, T_Value, T_KeyTraits, T_Allocator, DenseProbing> : private T_Allocator {
+
+public:
+    using Iterator = T_Value*;
+
+    enum : uint32_t { cEmptySlot = ~0u };
+
+    Table() = default;
+    explicit Table(size_t initialCount)
+        : Table() {
+        reserve(initialCount);
+    }
+    explicit Table(T_Allocator const& allocator)
+        : T_Allocator(allocator) {
+    }
+    Table(Table&& src)
+        : T_Allocator(std::move(src))
+        , slots_(std::exchange(src.slots_, nullptr))
+        , keys_(std::exchange(src.keys_, nullptr))
+        , values_(std::exchange(src.values_, nullptr))
+        , hashes_(std::exchange(src.hashes_, nullptr))
+        , count_(std::exchange(src.count_, 0))
+        , capacity_(std::exchange(src.capacity_, 0))
+        , mask_(std::exchange(src.mask_, 0)) {
+    }
+    ~Table() {
+        if (slots_) {
+            removeAll();
+            deallocate(hashes_);
+            deallocate(values_);
+            deallocate(keys_);
+            deallocate(slots_);
+        }
+    }
+
+    // Makes room for this many entries (not slots, unlike the linear-probing Table), in both the packed arrays
+    // and the index
+    void reserve(size_t count) {
+        if (count > capacity_) {
+            growEntries(std::max((size_t)capacity_ * 2, count));
+        }
+        if (!slots_ || GetSlotCountFor(count) > mask_ + 1) {
+            rehash(GetSlotCountFor(std::max(count, (size_t)capacity_)));
+        }
+    }
+
+    Iterator begin() const {
+        return values_;
+    }
+
+    Iterator end() const {
+        return values_ + count_;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    // The packed entries; keys()[i] goes with values()[i]
+    Span<T_Key const> keys() const {
+        return {keys_, count_};
+    }
+
+    Span<T_Value> values() const {
+        return {values_, count_};
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Value* add(T_Key&& key, T_Params&&... params) {
+        assert(!find(key));     // Already in table, use findOrAdd()
+        return store(T_KeyTraits::Hash(key), std::move(key), std::forward<T_Params>(params)...);
+    }
+
+    // Returned pointer is not stable!
+    T_Value* add(T_Key&& key, T_Value&& src) {
+        assert(!find(key));     // Already in table, use findOrAdd()
+        return store(T_KeyTraits::Hash(key), std::move(key), std::move(src));
+    }
+
+    T_Value remove(T_Key const& key) {
+        T_Value* const found = find(key);
+        assert(found);
+        return removeFound(found);
+    }
+
+    T_Value removeFound(T_Value* found) {
+        unsigned const entry = (unsigned)(found - values_);
+        assert(entry < count_);
+        return removeEntry(findEntrySlot(entry), entry);
+    }
+
+    // Returned pointer is not stable!
+    T_Value* fetch(T_Key const& key) const {
+        T_Value* const found = find(key);
+        assert(found);
+        return found;
+    }
+
+    // Returned pointer is not stable!
+    T_Value* find(T_Key const& key) const {
+        return slots_ ? findWithHash(key, T_KeyTraits::Hash(key)) : nullptr;
+    }
+
+    // find() for each key, into results (pointers are not stable!). A batch of keys is hashed and their home
+    // slots prefetched before any is probed, so the cache misses overlap.
+    void findBatch(Span<T_Key const> keys, Span<T_Value*> results) const {
+        assert(results.count() == keys.count());
+        uint32_t hashes[cFindBatchSize];
+        for (unsigned first = 0; first < keys.count(); first += cFindBatchSize) {
+            unsigned const count = std::min(keys.count() - first, (unsigned)cFindBatchSize);
+            for (unsigned i = 0; i < count && slots_; i++) {
+                hashes[i] = T_KeyTraits::Hash(keys[first + i]);
+                Prefetch(slots_ + (hashes[i] & mask_));
+            }
+            for (unsigned i = 0; i < count; i++) {
+                results[first + i] = slots_ ? findWithHash(keys[first + i], hashes[i]) : nullptr;
+            }
+        }
+    }
+
+    // Returned pointer is not stable!
+    template<class... T_Params>
+    T_Value* findOrAdd(T_Key&& key, T_Params&&... params) {
+        uint32_t const hash = T_KeyTraits::Hash(key);
+        if (slots_) {
+            if (T_Value* const found = findWithHash(key, hash)) {
+                return found;
+            }
+        }
+        return store(hash, std::move(key), std::forward<T_Params>(params)...);
+    }
+
+    void removeAll() {
+        if (slots_) {
+            DestroyArray(values_, count_);
+            DestroyArray(keys_, count_);
+            memset(slots_, 0xff, (mask_ + 1) * sizeof(uint32_t));
+            count_ = 0;
+        }
+    }
+
+    // Of the index
+    ProbeStats getProbeStats() const {
+        return Internal::GetLinearProbeStats(count_, mask_,
+            [this](unsigned slot) { return slots_[slot] != cEmptySlot; },
+            [this](unsigned slot) { return hashes_[slots_[slot]] & mask_; });
+    }
+
+private:
+    enum { cFindBatchSize = 16 };
+
+    // (At most half full)
+    static unsigned GetSlotCountFor(size_t count) {
+        return std::max(NextPow2((unsigned)count * 2), 8u);
+    }
+
+    template<class... T_Params>
+    T_Value* store(uint32_t hash, T_Key&& key, T_Params&&... params) {
+        assert(!T_KeyTraits::IsNull(key));
+        reserve(count_ + 1);
+        slots_[findFreeSlot(hash)] = count_;
+        hashes_[count_] = hash;
+        ConstructInPlace<T_Key>(keys_ + count_, std::move(key));
+        return ConstructInPlace<T_Value>(values_ + count_++, std::forward<T_Params>(params)...);
+    }
+
+    T_Value* findWithHash(T_Key const& key, uint32_t hash) const {
+        for (unsigned slot = hash & mask_; slots_[slot] != cEmptySlot; slot = (slot + 1) & mask_) {
+            uint32_t const entry = slots_[slot];
+            if (hashes_[entry] == hash && T_KeyTraits::Equals(keys_[entry], key)) {
+                return values_ + entry;
+            }
+        }
+        return nullptr;
+    }
+
+    unsigned findFreeSlot(uint32_t hash) const {
+        unsigned slot = hash & mask_;
+        while (slots_[slot] != cEmptySlot) {
+            slot = (slot + 1) & mask_;
+        }
+        return slot;
+    }
+
+    unsigned findEntrySlot(uint32_t entry) const {
+        unsigned slot = hashes_[entry] & mask_;
+        while (slots_[slot] != entry) {
+            assert(slots_[slot] != cEmptySlot);
+            slot = (slot + 1) & mask_;
+        }
+        return slot;
+    }
+
+    // Backward-shift deletes the index slot, then moves the last entry into the hole
+    T_Value removeEntry(unsigned slot, unsigned entry) {
+        T_Value removed = std::move(values_[entry]);
+        for (unsigned moving = (slot + 1) & mask_; slots_[moving] != cEmptySlot; moving = (moving + 1) & mask_) {
+            unsigned const target = hashes_[slots_[moving]] & mask_;
+            bool const a = target <= slot;
+            bool const b = slot < moving;
+            if (target <= moving ? (a & b) : (a | b)) {
+                slots_[slot] = slots_[moving];
+                slot = moving;
+            }
+        }
+        slots_[slot] = cEmptySlot;
+
+        unsigned const last = --count_;
+        if (entry != last) {
+            slots_[findEntrySlot(last)] = entry;
+            ReconstructInPlace(keys_[entry], std::move(keys_[last]));
+            ReconstructInPlace(values_[entry], std::move(values_[last]));
+            hashes_[entry] = hashes_[last];
+        }
+        keys_[last].~T_Key();
+        values_[last].~T_Value();
+        return removed;
+    }
+
+    GG_NO_INLINE void growEntries(size_t capacity) {
+        keys_ = ReallocateArray<T_Key, T_Allocator>(*this, keys_, 0, count_, capacity);
+        values_ = ReallocateArray<T_Value, T_Allocator>(*this, values_, 0, count_, capacity);
+        hashes_ = ReallocateArray<uint32_t, T_Allocator>(*this, hashes_, 0, count_, capacity);
+        capacity_ = (unsigned)capacity;
+    }
+
+    // Rebuilds the index from the cached hashes
+    GG_NO_INLINE void rehash(unsigned slotCount) {
+        deallocate(slots_);
+        slots_ = (uint32_t*)allocate(slotCount * sizeof(uint32_t), alignof(uint32_t));
+        mask_ = slotCount - 1;
+        memset(slots_, 0xff, slotCount * sizeof(uint32_t));
+        for (unsigned entry = 0; entry < count_; entry++) {
+            slots_[findFreeSlot(hashes_[entry])] = entry;
+        }
+    }
+
+    uint32_t* slots_ = nullptr;     // (entry indices, or cEmptySlot)
+    T_Key* keys_ = nullptr;
+    T_Value* values_ = nullptr;
+    uint32_t* hashes_ = nullptr;
+    unsigned count_ = 0;
+    unsigned capacity_ = 0;
+    unsigned mask_ = 0;
+};
+
+template<class T_Key, class T_Value, class T_KeyTraits = HashKeyTraitsDefault<T_Key>, class T_Allocator = Mallocator>
+using DenseTable = Table<T_Key, T_Value, T_KeyTraits, T_Allocator, DenseProbing>;
+
 }
 
 #endif
@@ -0,0 +1,81 @@
+#include "TrackingAllocator.h"
+#include <cstdio>
+
+namespace gg {
+
+std::atomic<AllocationTag*> AllocationTag::s_firstTag = {nullptr};
+
+AllocationTag::AllocationTag(char const* name, bool trackLiveBlocks)
+    : name_(name)
+    , trackLiveBlocks_(trackLiveBlocks)
+    , nextTag_(s_firstTag.load(std::memory_order_relaxed)) {
+    while (!s_firstTag.compare_exchange_weak(nextTag_, this, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+AllocationTag* AllocationTag::Untagged() {
+    static AllocationTag untagged("untagged");
+    return &untagged;
+}
+
+void AllocationTag::recordAllocation(Header* header) {
+    int64_t const bytes = (int64_t)header->bytes;
+    allocationCount_.fetch_add(1, std::memory_order_relaxed);
+    unsigned const bucket = header->bytes ? FloorLog2((uint64_t)header->bytes) : 0;
+    sizeHistogram_[std::min(bucket, (unsigned)cHistogramBucketCount - 1)].fetch_add(1, std::memory_order_relaxed);
+    int64_t const current = currentBytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    int64_t peak = peakBytes_.load(std::memory_order_relaxed);
+    while (current > peak && !peakBytes_.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+    if (trackLiveBlocks_) {
+        std::lock_guard<std::mutex> lock(liveMutex_);
+        header->prev = nullptr;
+        header->next = live_;
+        if (live_) {
+            live_->prev = header;
+        }
+        live_ = header;
+    }
+}
+
+void AllocationTag::recordFree(Header* header) {
+    freeCount_.fetch_add(1, std::memory_order_relaxed);
+    currentBytes_.fetch_sub((int64_t)header->bytes, std::memory_order_relaxed);
+    if (trackLiveBlocks_) {
+        std::lock_guard<std::mutex> lock(liveMutex_);
+        (header->prev ? header->prev->next : live_) = header->next;
+        if (header->next) {
+            header->next->prev = header->prev;
+        }
+    }
+}
+
+void AllocationTag::Report(void (*printLine)(char const* text)) {
+    char line[256];
+    for (AllocationTag* tag = s_firstTag.load(std::memory_order_acquire); tag; tag = tag->nextTag_) {
+        snprintf(line, sizeof(line), "%s: %llu allocs, %llu frees, %lld bytes live, %lld bytes peak\n",
+            tag->name_,
+            (unsigned long long)tag->allocationCount(),
+            (unsigned long long)tag->freeCount(),
+            (long long)tag->currentBytes(),
+            (long long)tag->peakBytes());
+        printLine(line);
+        for (unsigned bucket = 0; bucket < cHistogramBucketCount; bucket++) {
+            if (uint64_t const count = tag->histogramCount(bucket)) {
+                if (bucket + 1 < cHistogramBucketCount) {
+                    snprintf(line, sizeof(line), "    [%llu, %llu) bytes: %llu\n", 1ull << bucket, 2ull << bucket, (unsigned long long)count);
+                } else {
+                    snprintf(line, sizeof(line), "    %llu+ bytes: %llu\n", 1ull << bucket, (unsigned long long)count);
+                }
+                printLine(line);
+            }
+        }
+        std::lock_guard<std::mutex> lock(tag->liveMutex_);
+        for (Header const* header = tag->live_; header; header = header->next) {
+            snprintf(line, sizeof(line), "    live block %p: %llu bytes\n", (void const*)(header + 1), (unsigned long long)header->bytes);
+            printLine(line);
+        }
+    }
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef GG_TRACKING_ALLOCATOR_H
+#define GG_TRACKING_ALLOCATOR_H
+
+#include "Allocator.h"
+#include <atomic>
+#include <mutex>
+
+namespace gg {
+
+// Named bucket of allocation statistics. Tags register themselves for Report(), and are expected to have static
+// storage duration.
+// The counters are always on. Listing live blocks costs a lock per allocation and free, so it's per tag, in any
+// build: pass trackLiveBlocks.
+class AllocationTag {
+public:
+    enum { cHistogramBucketCount = 32 };    // bucket i counts blocks of [2^i, 2^(i+1)) bytes, the last any larger
+
+    explicit AllocationTag(char const* name, bool trackLiveBlocks = false);
+    AllocationTag(AllocationTag const&) = delete;
+
+    static AllocationTag* Untagged();
+
+    // Prints every tag's counters, size histogram and (if tracked) live blocks, one line at a time
+    static void Report(void (*printLine)(char const* text));
+
+    char const* name() const {
+        return name_;
+    }
+    bool tracksLiveBlocks() const {
+        return trackLiveBlocks_;
+    }
+    uint64_t allocationCount() const {
+        return allocationCount_.load(std::memory_order_relaxed);
+    }
+    uint64_t freeCount() const {
+        return freeCount_.load(std::memory_order_relaxed);
+    }
+    int64_t currentBytes() const {
+        return currentBytes_.load(std::memory_order_relaxed);
+    }
+    int64_t peakBytes() const {
+        return peakBytes_.load(std::memory_order_relaxed);
+    }
+    uint64_t histogramCount(unsigned bucket) const {
+        assert(bucket < cHistogramBucketCount);
+        return sizeHistogram_[bucket].load(std::memory_order_relaxed);
+    }
+
+private:
+    template<class T_Inner> friend class TrackingAllocator;
+
+    struct Header {
+        AllocationTag* tag;
+        size_t bytes;
+        size_t offset;
+        Header* prev;   // (live block list, if the tag tracks it)
+        Header* next;
+    };
+
+    void recordAllocation(Header* header);
+    void recordFree(Header* header);
+
+    char const* name_;
+    bool const trackLiveBlocks_;
+    AllocationTag* nextTag_;
+    std::atomic<uint64_t> allocationCount_ = {0};
+    std::atomic<uint64_t> freeCount_ = {0};
+    std::atomic<int64_t> currentBytes_ = {0};
+    std::atomic<int64_t> peakBytes_ = {0};
+    std::atomic<uint64_t> sizeHistogram_[cHistogramBucketCount] = {};
+    std::mutex liveMutex_;
+    Header* live_ = nullptr;
+
+    static std::atomic<AllocationTag*> s_firstTag;
+};
+
+// Wraps any T_Allocator (use IAllocatorPtr to wrap an IAllocator), counting its traffic against an AllocationTag
+template<class T_Inner>
+class TrackingAllocator : private T_Inner {
+public:
+    TrackingAllocator()
+        : tag_(AllocationTag::Untagged()) {
+    }
+    TrackingAllocator(AllocationTag* tag)
+        : tag_(tag) {
+    }
+    TrackingAllocator(AllocationTag* tag, T_Inner const& inner)
+        : T_Inner(inner)
+        , tag_(tag) {
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        using Header = AllocationTag::Header;
+        size_t const offset = (sizeof(Header) + alignment - 1) & ~(alignment - 1);
+        char* const base = (char*)T_Inner::allocate(offset + bytes, std::max(alignment, alignof(Header)));
+        Header* const header = (Header*)(base + offset) - 1;
+        header->tag = tag_;
+        header->bytes = bytes;
+        header->offset = offset;
+        tag_->recordAllocation(header);
+        return base + offset;
+    }
+
+    void deallocate(void const* p) {
+        using Header = AllocationTag::Header;
+        if (!p) {
+            return;
+        }
+        Header* const header = (Header*)p - 1;
+        header->tag->recordFree(header);
+        T_Inner::deallocate((char*)p - header->offset);
+    }
+
+    AllocationTag* tag() const {
+        return tag_;
+    }
+
+private:
+    AllocationTag* tag_;
+};
+
+}
+
+#endif
@@ -0,0 +1,202 @@
+#pragma once
+#ifndef GG_VIRTUAL_ARRAY_H
+#define GG_VIRTUAL_ARRAY_H
+
+#include "Os.h"
+#include "Span.h"
+#include "MiscUtil.h"
+#include <cstdlib>
+
+namespace gg {
+
+// Array that reserves address space for maxCapacity elements up front and commits pages as it grows,
+// so growing never moves elements and pointers into it stay valid. Running out of the reserved range, or of
+// memory to commit, aborts (in every build): there is nowhere else to put the elements.
+template<class T>
+class VirtualArray {
+
+    struct MaxCapacity {
+        size_t count;
+    };
+
+public:
+    enum : size_t { cDefaultReservedBytes = (size_t)1 << 30 };
+
+    VirtualArray()
+        : VirtualArray(MaxCapacity{cDefaultReservedBytes / sizeof(T)}) {
+    }
+    // (Initial capacity, like Array's; the reserved range is sized with WithMaxCapacity())
+    explicit VirtualArray(size_t initialCapacity)
+        : VirtualArray() {
+        reserve(initialCapacity);
+    }
+    VirtualArray(VirtualArray&& src)
+        : data_(std::exchange(src.data_, nullptr))
+        , count_(std::exchange(src.count_, 0))
+        , capacity_(std::exchange(src.capacity_, 0))
+        , maxCapacity_(src.maxCapacity_)
+        , committedBytes_(std::exchange(src.committedBytes_, 0)) {
+    }
+    VirtualArray(VirtualArray const&) = delete;
+
+    static VirtualArray WithMaxCapacity(size_t maxCapacity) {
+        return VirtualArray(MaxCapacity{maxCapacity});
+    }
+
+    ~VirtualArray() {
+        removeAll();
+        if (data_) {
+            Os::ReleaseAddressSpace(data_, getReservedBytes());
+        }
+    }
+
+    VirtualArray& operator=(VirtualArray&& src) {
+        ReconstructInPlace(*this, std::move(src));
+        return *this;
+    }
+
+    T& addLast(T const& source) {
+        return *ConstructInPlace<T>(emplaceLast(1), source);
+    }
+
+    T& addLast(T&& source) {
+        return *ConstructInPlace<T>(emplaceLast(1), std::move(source));
+    }
+
+    template<class... T_Params>
+    T& addLast(T_Params&&... params) {
+        return *ConstructInPlace<T>(emplaceLast(1), std::forward<T_Params>(params)...);
+    }
+
+    T* addLastN(size_t n) {
+        return ConstructArray<T>(emplaceLast(n), n);
+    }
+
+    T* addLastCopiedSpan(Span<T const> span) {
+        return CopyConstructArray<T>(emplaceLast(span.count()), span.count(), span.begin());
+    }
+
+    T* addLastMovedSpan(Span<T>&& span) {
+        Span<T> temp = std::move(span);
+        return MoveArray<T>(emplaceLast(temp.count()), temp.count(), temp.begin());
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity);
+        }
+    }
+
+    void* emplaceLast(size_t n) {
+        reserve(count_ + n);
+        return (std::remove_const_t<T>*)&data_[std::exchange(count_, count_ + (unsigned)n)];
+    }
+
+    T removeLast() {
+        assert(count_ > 0);
+        return std::move(data_[--count_]);
+    }
+
+    void removeLastN(size_t n) {
+        assert(count_ >= n);
+        for (size_t i = 0; i < n; i++) {
+            data_[count_ - i - 1].~T();
+        }
+        count_ -= (unsigned)n;
+    }
+
+    void removeAll() {
+        removeLastN(count_);
+    }
+
+    void setCount(size_t count) {
+        if (count < count_) {
+            removeLastN(count_ - count);
+        } else {
+            emplaceLast(count - count_);
+        }
+    }
+
+    T* begin() const {
+        return data_;
+    }
+
+    T* end() const {
+        return data_ + count_;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    unsigned maxCapacity() const {
+        return maxCapacity_;
+    }
+
+    T& operator[](size_t i) const {
+        assert(i < count_);
+        return data_[i];
+    }
+
+    Span<T> slice(size_t start, size_t end) const {
+        assert(start <= end && end <= count_);
+        return {data_ + start, end - start};
+    }
+
+    operator Span<T>() const {
+        return {data_, count_};
+    }
+
+    // (Only for mutable T, where it differs from the one above)
+    template<class T_Elem = T, class = std::enable_if_t<!std::is_const<T_Elem>::value>>
+    operator Span<T const>() const {
+        return {data_, count_};
+    }
+
+private:
+    explicit VirtualArray(MaxCapacity maxCapacity)
+        : maxCapacity_((unsigned)maxCapacity.count) {
+        assert(maxCapacity_ == maxCapacity.count);
+    }
+
+    size_t getReservedBytes() const {
+        size_t const pageMask = Os::GetPageSize() - 1;
+        return ((size_t)maxCapacity_ * sizeof(T) + pageMask) & ~pageMask;
+    }
+
+    GG_NO_INLINE void grow(size_t requestedCapacity) {
+        assert((unsigned)requestedCapacity > capacity_);
+        if (requestedCapacity > maxCapacity_) {
+            assert(!"Reserved range exhausted");
+            std::abort();
+        }
+        size_t const reservedBytes = getReservedBytes();
+        if (!data_) {
+            data_ = (T*)Os::ReserveAddressSpace(reservedBytes);
+            if (!data_) {
+                assert(!"Out of address space");
+                std::abort();
+            }
+        }
+        // Commit geometrically, so appending is amortized O(1) in system calls too
+        size_t const pageMask = Os::GetPageSize() - 1;
+        size_t const neededBytes = std::max(requestedCapacity * sizeof(T), 2 * committedBytes_);
+        size_t const commitBytes = std::min((neededBytes + pageMask) & ~pageMask, reservedBytes);
+        if (!Os::CommitPages((char*)data_ + committedBytes_, commitBytes - committedBytes_)) {
+            assert(!"Out of memory");
+            std::abort();
+        }
+        committedBytes_ = commitBytes;
+        capacity_ = (unsigned)std::min(committedBytes_ / sizeof(T), (size_t)maxCapacity_);
+    }
+
+    T* data_ = nullptr;
+    unsigned count_ = 0;
+    unsigned capacity_ = 0;
+    unsigned maxCapacity_;
+    size_t committedBytes_ = 0;
+};
+
+}
+
+#endif
@@ -78,6 +78,14 @@ struct MovableHandle {
     T handle;
 };
 
+}
+
+template<class T>
+struct IsTriviallyRelocatable<vk::MovableHandle<T>> : std::true_type {
+};
+
+namespace vk {
+
 struct DestroyOverloads {
     static void Destroy(VkDevice device, VkBuffer handle, VkAllocationCallbacks const* allocator) { vkDestroyBuffer(device, handle, allocator); }
     static void Destroy(VkDevice device, VkImage handle, VkAllocationCallbacks const* allocator) { vkDestroyImage(device, handle, allocator); }
@@ -120,8 +128,8 @@ public:
     }
     void waitForAll(VkDevice device) {
         if (submittedFences_.count()) {
-            auto fences = GG_STACK_ARRAY(VkFence, submittedFences_.count());
-            submittedFences_.linearizeCopy(fences);
+            ScratchScope scratch;
+            auto fences = submittedFences_.linearizeCopy(scratch.newArray<VkFence>(submittedFences_.count()));
             vkWaitForFences(device, submittedFences_.count(), fences, true, ~0);
             signalledFenceValue_ += submittedFences_.count();
             for (VkFence fence : submittedFences_) {
@@ -157,7 +165,8 @@ public:
         if (recycling_.count() == 0) {
             return;
         }
-        auto* commandBuffers = GG_STACK_ARRAY(VkCommandBuffer, recycling_.count());
+        ScratchScope scratch;
+        auto* commandBuffers = scratch.newArray<VkCommandBuffer>(recycling_.count());
         for (unsigned i = 0; i < recycling_.count(); i++) {
             commandBuffers[i] = recycling_[i].commandBuffer;
         }